@@ -0,0 +1,352 @@
+#include "ofMain.h"
+#include "globals.h"
+#include "vv_map_projections.h"
+#include "vv_extrude_font.h"
+#include "vv_geojson.h"
+#include "SandLine.h"
+#include "Firework.h"
+#include "TweetHistory.h"
+#include "CountryLocator.h"
+#include "TrendTracker.h"
+#include <unordered_map>
+
+//--------------------------------------------------------------
+// Microbenchmarks of the core kernels, no app and nothing on screen
+// (a hidden window is created only for the gl context needed by fonts and fbos).
+//
+// usage: bin/bench [--json results.json] [--csv results.csv] [--filter name] [--scale 0.1]
+//        [--traffic hashtags.txt]
+//--------------------------------------------------------------
+
+struct BenchResult {
+    std::string name;
+    int iterations;
+    int items; // per iteration, e.g. the points projected
+    double mean, stdev, min, median, p95, max; // micros per iteration
+    double recall, overcount; // the sketches only: top k found, mean overcount of the top (%); -1 otherwise
+};
+
+//--------------------------------------------------------------
+// @short:  times body() for the given number of iterations, after a few warm-up runs
+// @args:   prepare: called before each iteration, not timed
+// @return: the per-iteration statistics
+//--------------------------------------------------------------
+BenchResult run_bench(std::string name, int iterations, int items, std::function<void()> prepare, std::function<void()> body){
+
+    int warm_up = std::max(1, iterations / 10);
+    for (int i = 0; i < warm_up; i++){
+        if (prepare) prepare();
+        body();
+    }
+
+    vector <double> times(iterations);
+    for (int i = 0; i < iterations; i++){
+        if (prepare) prepare();
+        uint64_t start = ofGetElapsedTimeMicros();
+        body();
+        times[i] = ofGetElapsedTimeMicros() - start;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.items = items;
+    result.recall = -1;
+    result.overcount = -1;
+
+    double sum = 0;
+    for (int i = 0; i < iterations; i++) sum += times[i];
+    result.mean = sum / iterations;
+
+    double squares = 0;
+    for (int i = 0; i < iterations; i++) squares += (times[i] - result.mean) * (times[i] - result.mean);
+    result.stdev = sqrt(squares / iterations);
+
+    std::sort(times.begin(), times.end());
+    result.min = times.front();
+    result.max = times.back();
+    result.median = times[iterations / 2];
+    result.p95 = times[std::min(iterations - 1, int(iterations * 0.95))];
+
+    printf("%-32s %8d it %12.1f us mean %10.1f stdev %10.1f min %10.1f median %10.1f p95 %10.1f max",
+        name.c_str(), iterations, result.mean, result.stdev, result.min, result.median, result.p95, result.max);
+    if (items > 1) printf(" (%.1f ns per item)", result.mean * 1000 / items);
+    printf("\n");
+
+    return result;
+}
+
+//--------------------------------------------------------------
+bool save_json(std::string path, vector<BenchResult> & results){
+
+    ofstream out(path.c_str());
+    if (!out.is_open()) return false;
+
+    out << "{\"timestamp\": \"" << ofGetTimestampString("%Y-%m-%d %H:%M:%S") << "\", \"unit\": \"us\", \"results\": [" << endl;
+    for (int r = 0; r < results.size(); r++){
+        BenchResult & b = results[r];
+        out << "  {\"name\": \"" << b.name << "\", \"iterations\": " << b.iterations << ", \"items\": " << b.items;
+        out << ", \"mean\": " << b.mean << ", \"stdev\": " << b.stdev << ", \"min\": " << b.min;
+        out << ", \"median\": " << b.median << ", \"p95\": " << b.p95 << ", \"max\": " << b.max;
+        if (b.recall >= 0) out << ", \"recall\": " << b.recall << ", \"overcount_percent\": " << b.overcount;
+        out << "}";
+        out << (r < results.size() - 1 ? "," : "") << endl;
+    }
+    out << "]}" << endl;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool save_csv(std::string path, vector<BenchResult> & results){
+
+    ofstream out(path.c_str());
+    if (!out.is_open()) return false;
+
+    out << "name,iterations,items,mean_us,stdev_us,min_us,median_us,p95_us,max_us,recall,overcount_percent" << endl;
+    for (int r = 0; r < results.size(); r++){
+        BenchResult & b = results[r];
+        out << b.name << "," << b.iterations << "," << b.items << "," << b.mean << "," << b.stdev << ",";
+        out << b.min << "," << b.median << "," << b.p95 << "," << b.max << ",";
+        if (b.recall >= 0) out << b.recall << "," << b.overcount;
+        else out << ",";
+        out << endl;
+    }
+    return true;
+}
+
+//========================================================================
+int main(int argc, char * argv[]){
+
+    std::string json_path, csv_path, filter, traffic_path;
+    float scale = 1; // multiplies the iterations, for quick runs
+    for (int a = 1; a < argc - 1; a++){
+        std::string arg = argv[a];
+        if (arg == "--json") json_path = argv[++a];
+        else if (arg == "--csv") csv_path = argv[++a];
+        else if (arg == "--filter") filter = argv[++a];
+        else if (arg == "--scale") scale = ofToFloat(argv[++a]);
+        else if (arg == "--traffic") traffic_path = argv[++a];
+    }
+
+    // fonts and fbos need a gl context, but nothing is ever drawn
+    ofGLFWWindowSettings settings;
+    settings.width = 64;
+    settings.height = 64;
+    settings.visible = false;
+    ofCreateWindow(settings);
+
+    // the bench lives in bench/bin, the data of the app in bin/data
+#ifdef TARGET_OSX
+    ofSetDataPathRoot("../../../../../bin/data/");
+#else
+    ofSetDataPathRoot("../../bin/data/");
+#endif
+
+    ofSeedRandom(42);
+    vv_trace::set_enabled(false);
+
+    ofTrueTypeFont font;
+    font.load("fonts/AndaleMono.ttf", 15, true, true, true, 1.0f);
+
+    // typical city names, as they come from the geojson
+    vector <std::string> city_names = {"#london", "#new york", "#tokyo", "#rio de janeiro", "#reykjavik", "#buenos aires", "#athens", "#kuala lumpur"};
+
+    vector <BenchResult> results;
+    auto bench = [&](std::string name, int iterations, int items, std::function<void()> prepare, std::function<void()> body){
+        if (!filter.empty() && name.find(filter) == std::string::npos) return;
+        results.push_back(run_bench(name, std::max(1, int(iterations * scale)), items, prepare, body));
+    };
+
+    // PROJECTIONS
+    const int num_coords = 10000;
+    vector <float> lons(num_coords), lats(num_coords);
+    for (int i = 0; i < num_coords; i++){
+        lons[i] = ofRandom(-180, 180);
+        lats[i] = ofRandom(-85, 85);
+    }
+    ofPoint projected_sum;
+    bench("mercator", 1000, num_coords, nullptr, [&](){
+        for (int i = 0; i < num_coords; i++){
+            projected_sum += vv_map_projections::mercator(lons[i], lats[i], WIDTH / (2 * PI));
+        }
+    });
+
+    // GEOJSON
+    bench("create_geojson_map", 10, 1, nullptr, [&](){
+        vector <ofMesh> poly_meshes;
+        vector <vv_geojson::City> cities;
+        vv_geojson::create_geojson_map("world_cities_countries.geojson", font, poly_meshes, cities, WIDTH / (2 * PI));
+    });
+
+    // COUNTRIES
+    // random coordinates, most of them in the sea like the tweets aren't, so the borders are hit too
+    vector <ofMesh> country_meshes;
+    vector <vv_geojson::City> country_cities;
+    vector <vv_geojson::Country> countries;
+    vv_geojson::create_geojson_map("world_cities_countries.geojson", font, country_meshes, country_cities, WIDTH / (2 * PI), NULL, &countries);
+    CountryLocator locator;
+    bench("CountryLocator::setup", 20, countries.size(), nullptr, [&](){
+        locator.setup(countries);
+    });
+    vector <ofPoint> locations(num_coords);
+    for (int i = 0; i < num_coords; i++){
+        locations[i] = vv_map_projections::mercator(lons[i], lats[i], WIDTH / (2 * PI));
+    }
+    int located = 0;
+    bench("CountryLocator::find", 1000, num_coords, nullptr, [&](){
+        for (int i = 0; i < num_coords; i++){
+            located += locator.find(locations[i]);
+        }
+    });
+    bench("CountryLocator::find_exact", 5, num_coords / 10, nullptr, [&](){
+        for (int i = 0; i < num_coords / 10; i++){
+            located += locator.find_exact(locations[i]);
+        }
+    });
+    if (filter.empty() || std::string("CountryLocator::find").find(filter) != std::string::npos){
+        int mismatches = 0, on_land = 0;
+        for (int i = 0; i < num_coords; i++){
+            int country = locator.find_exact(locations[i]);
+            if (locator.find(locations[i]) != country) mismatches++;
+            if (country >= 0) on_land++;
+        }
+        printf("%-32s %d countries, %d cells, %.1f%% on borders, %d KB: %d of %d points on land, %d differ from find_exact\n",
+            "CountryLocator accuracy", locator.get_num_countries(), locator.get_num_cells(), locator.get_boundary_ratio() * 100,
+            int(locator.get_bytes() / 1024), on_land, num_coords, mismatches);
+    }
+
+    // TEXT
+    bench("extrude_mesh_from_text", 200, city_names.size(), nullptr, [&](){
+        for (int n = 0; n < city_names.size(); n++){
+            extrude_mesh_from_text(city_names[n], font, 2, 0.012, true);
+        }
+    });
+    bench("get_string_as_sampled_points", 200, city_names.size(), nullptr, [&](){
+        for (int n = 0; n < city_names.size(); n++){
+            get_string_as_sampled_points(font, city_names[n], 60);
+        }
+    });
+
+    // SAND LINE
+    // every point after the first one generates the grains of a bezier stroke
+    SandLine sand_line;
+    sand_line.setup(WIDTH/2, HEIGHT, 1, 35);
+    sand_line.set_mode(SandLine::BEZIER_MODE);
+    sand_line.add_point(ofPoint(WIDTH/4, HEIGHT/2), 64, 48);
+    bench("SandLine::add_point", 2000, 1, [&](){
+        // update() would pop it while drawing
+        if (sand_line.main_sand_points.size() > 1) sand_line.main_sand_points.pop_front();
+    }, [&](){
+        sand_line.add_point(ofPoint(ofRandom(WIDTH/2), ofRandom(HEIGHT)), ofRandom(255) * 0.5f, ofRandom(32, 64));
+    });
+
+    // FIREWORKS
+    // one frame of the most fireworks the app keeps around, right after they exploded
+    const int num_fireworks = 16;
+    vector <Firework> fireworks(num_fireworks);
+    bench("Firework::update", 2000, num_fireworks, [&](){
+        for (int f = 0; f < num_fireworks; f++){
+            fireworks[f].setup(ofPoint(ofRandom(-100, 100), ofRandom(-100, 100), 0), ofFloatColor(0.0f));
+            while (!fireworks[f].exploded()) fireworks[f].update();
+        }
+    }, [&](){
+        for (int f = 0; f < num_fireworks; f++){
+            fireworks[f].update();
+        }
+    });
+
+    // TWEET HISTORY
+    // a couple of weeks of a busy stream, 10 tweets per second
+    const int num_tweets = 2000000;
+    TweetHistory history;
+    uint32_t start_time = 1500000000;
+    vector <std::string> history_cities;
+    for (int c = 0; c < 215; c++) history_cities.push_back("city " + ofToString(c));
+    for (int i = 0; i < num_tweets; i++){
+        history.add(start_time + i / 10, history_cities[i % 215], i % 3 ? "Italy" : "Japan", -1, -1, "#bench");
+    }
+    uint32_t end_time = start_time + num_tweets / 10;
+    int history_count = 0;
+    bench("TweetHistory::count_range", 200, num_tweets, nullptr, [&](){
+        // the last day, like the "today" view
+        history_count += history.count_range(end_time - 86400, end_time + 1);
+    });
+    vector <int> city_counts;
+    bench("TweetHistory::count_by_city", 200, num_tweets, nullptr, [&](){
+        // a range that cuts through chunks, so every row is scanned
+        history.count_by_city(start_time + 1234, end_time - 1234, city_counts);
+    });
+
+    // TRENDS
+    // recorded hashtags (one per line) when given, otherwise a zipf stream like the real one:
+    // a few hashtags everywhere, a long tail seen once or twice
+    vector <std::string> traffic;
+    if (!traffic_path.empty()){
+        ofBuffer buffer = ofBufferFromFile(traffic_path);
+        for (auto & line : buffer.getLines()){
+            if (!line.empty()) traffic.push_back(line);
+        }
+        if (traffic.empty()) ofLogError() << "no hashtags in " << traffic_path;
+    }
+    if (traffic.empty()){
+        const int num_keys = 100000;
+        vector <double> cumulative(num_keys);
+        double total = 0;
+        for (int k = 0; k < num_keys; k++){
+            total += 1 / pow(k + 1, 1.1);
+            cumulative[k] = total;
+        }
+        traffic.resize(1000000);
+        for (int i = 0; i < traffic.size(); i++){
+            int k = std::lower_bound(cumulative.begin(), cumulative.end(), ofRandom(total)) - cumulative.begin();
+            traffic[i] = "#tag" + ofToString(std::min(k, num_keys - 1));
+        }
+    }
+
+    // no decay over the bench (the half life is ages), so the counts can be checked against exact ones
+    TrendTracker trends;
+    bench("TrendTracker::add", 10, traffic.size(), [&](){
+        trends.setup(4, 4096, 10, 1e9);
+    }, [&](){
+        for (int i = 0; i < traffic.size(); i++){
+            trends.add(traffic[i], 1, 0);
+        }
+    });
+
+    // the accuracy goes in the results of the add() run above, the last one
+    if (!results.empty() && results.back().name == "TrendTracker::add"){
+
+        std::unordered_map <std::string, int> exact;
+        for (int i = 0; i < traffic.size(); i++) exact[traffic[i]]++;
+        vector <std::pair<int, std::string> > exact_top;
+        for (auto & count : exact) exact_top.push_back(std::make_pair(count.second, count.first));
+        int k = std::min(10, int(exact_top.size()));
+        std::partial_sort(exact_top.begin(), exact_top.begin() + k, exact_top.end(), std::greater<std::pair<int, std::string> >());
+
+        // queried at the time of the adds, not at the clock of the bench
+        vector <TrendTracker::Trend> top = trends.get_top(0);
+        int found = 0;
+        double error = 0;
+        for (int t = 0; t < k; t++){
+            for (int s = 0; s < top.size(); s++){
+                if (top[s].key == exact_top[t].second) found++;
+            }
+            error += (trends.get_count(exact_top[t].second, 0) - exact_top[t].first) / exact_top[t].first;
+        }
+        results.back().recall = found / float(k);
+        results.back().overcount = 100 * error / k;
+        printf("%-32s %d events, %d keys, %d bytes: top %d recall %.2f, mean overcount of the top %.3f%%\n",
+            "TrendTracker accuracy", int(traffic.size()), int(exact.size()), int(trends.get_bytes()),
+            k, found / float(k), 100 * error / k);
+    }
+
+    // keep the compiler from throwing the projections away
+    if (projected_sum.x == 12345) cout << projected_sum << endl;
+    if (history_count == 12345) cout << history_count << endl;
+    if (located == 12345) cout << located << endl;
+
+    if (!json_path.empty() && !save_json(json_path, results)) ofLogError() << "couldn't write " << json_path;
+    if (!csv_path.empty() && !save_csv(csv_path, results)) ofLogError() << "couldn't write " << csv_path;
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "AssetLoader.h"
+
+//--------------------------------------------------------------
+AssetLoader::AssetLoader(){
+    _num_jobs = 0;
+    _num_done = 0;
+    _stopping = false;
+}
+
+//--------------------------------------------------------------
+AssetLoader::~AssetLoader(){
+    stop();
+}
+
+//--------------------------------------------------------------
+// jobs must be added before start(), they run in any order
+//--------------------------------------------------------------
+void AssetLoader::add_job(std::string name, std::function<void()> work, std::function<void()> finalize){
+
+    Job job;
+    job.name = name;
+    job.work = work;
+    job.finalize = finalize;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _pending.push_back(job);
+    _num_jobs++;
+}
+
+//--------------------------------------------------------------
+// same as add_job(), for a finalizer that does a slice of its work per call
+//--------------------------------------------------------------
+void AssetLoader::add_sliced_job(std::string name, std::function<void()> work, std::function<bool()> finalize_slice){
+
+    Job job;
+    job.name = name;
+    job.work = work;
+    job.finalize_slice = finalize_slice;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _pending.push_back(job);
+    _num_jobs++;
+}
+
+//--------------------------------------------------------------
+void AssetLoader::start(int num_workers){
+    for (int w = 0; w < num_workers; w++){
+        _workers.push_back(std::thread(&AssetLoader::worker, this));
+    }
+}
+
+//--------------------------------------------------------------
+// runs the finalizers of the finished jobs, at least one (or one slice)
+// per frame and then more only while there's time left in the budget
+//--------------------------------------------------------------
+void AssetLoader::update(float budget_ms){
+
+    uint64_t start_time = ofGetElapsedTimeMicros();
+
+    while (true){
+
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_finalizing.empty()) break;
+            job = _finalizing.front();
+            _finalizing.pop_front();
+        }
+
+        if (job.finalize){
+            vv_trace::Span span("finalize " + job.name);
+            job.finalize();
+        }
+        else if (job.finalize_slice){
+            bool finished;
+            {
+                vv_trace::Span span("finalize " + job.name + " (slice)");
+                finished = job.finalize_slice();
+            }
+            // not finished: first in line for the next slice
+            if (!finished){
+                std::unique_lock<std::mutex> lock(_mutex);
+                _finalizing.push_front(job);
+                if (ofGetElapsedTimeMicros() - start_time > budget_ms * 1000) break;
+                continue;
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _num_done++;
+            cout << "AssetLoader: " << job.name << " ready (" << _num_done << "/" << _num_jobs << ")" << endl;
+        }
+
+        if (ofGetElapsedTimeMicros() - start_time > budget_ms * 1000) break;
+    }
+
+    // the workers are not needed anymore
+    if (is_done()) stop();
+}
+
+//--------------------------------------------------------------
+void AssetLoader::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    for (int w = 0; w < _workers.size(); w++){
+        if (_workers[w].joinable()) _workers[w].join();
+    }
+    _workers.clear();
+}
+
+//--------------------------------------------------------------
+bool AssetLoader::is_done(){
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _num_done == _num_jobs;
+}
+
+//--------------------------------------------------------------
+int AssetLoader::get_num_jobs(){
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _num_jobs;
+}
+
+//--------------------------------------------------------------
+int AssetLoader::get_num_done(){
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _num_done;
+}
+
+//--------------------------------------------------------------
+void AssetLoader::worker(){
+
+    while (true){
+
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_stopping || _pending.empty()) return;
+            job = _pending.front();
+            _pending.pop_front();
+        }
+
+        {
+            vv_trace::Span span(job.name);
+            job.work();
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _finalizing.push_back(job);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_trace.h"
+
+//--------------------------------------------------------------
+// Loads the heavy assets while the intro screen is already up.
+// Each job has a work function, run on one of the worker threads, and an
+// optional finalize function for what needs the gl context (uploads):
+// finalizers run on the main thread inside update(), only as many as fit
+// in the given time budget per frame. A finalizer too big for a frame can
+// be split in slices: it's called again, the next frame if needed, until it
+// returns true.
+//
+// @example:
+//
+// void ofApp::setup(){
+//     loader.add_job("sounds", [this](){ /* decode */ }, [this](){ /* upload */ });
+//     loader.add_sliced_job("map", [this](){ /* parse, build meshes */ }, [this](){ return map.upload_slice(...); });
+//     loader.start(2);
+// }
+//
+// void ofApp::update(){
+//     loader.update(4);
+//     if (!loader.is_done()) return;
+// }
+//--------------------------------------------------------------
+
+class AssetLoader {
+
+    public:
+
+        AssetLoader();
+        ~AssetLoader();
+
+        void add_job(std::string name, std::function<void()> work, std::function<void()> finalize = nullptr);
+        void add_sliced_job(std::string name, std::function<void()> work, std::function<bool()> finalize_slice); // true when finished
+        void start(int num_workers);
+        void update(float budget_ms); // main thread
+        void stop();
+
+        bool is_done();
+        int get_num_jobs();
+        int get_num_done();
+
+    private:
+
+        struct Job {
+            std::string name;
+            std::function<void()> work;
+            std::function<void()> finalize;
+            std::function<bool()> finalize_slice;
+        };
+
+        void worker();
+
+        vector <std::thread> _workers;
+        std::mutex _mutex;
+        deque <Job> _pending; // waiting for a worker
+        deque <Job> _finalizing; // waiting for the main thread
+        int _num_jobs, _num_done;
+        bool _stopping;
+};
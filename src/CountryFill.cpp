@@ -0,0 +1,294 @@
+#include "CountryFill.h"
+
+//--------------------------------------------------------------
+CountryFill::CountryFill(){
+    _num_countries = 0;
+    _num_triangles = 0;
+    _vertex_buffer = 0;
+    _tex_coord_buffer = 0;
+    _index_buffer = 0;
+    _texture = 0;
+    _uploaded_bytes = 0;
+    _tessellation_ms = 0;
+
+    color = ofFloatColor(0.0, 0.35);
+    activity_half_life = 300;
+    saturation_activity = 20;
+}
+
+//--------------------------------------------------------------
+CountryFill::~CountryFill(){
+    clear();
+}
+
+//--------------------------------------------------------------
+// @desc:   tessellates every country and packs all the triangles together
+// @args:   countries: as filled by vv_geojson::create_geojson_map()
+//          scheduler: spreads the countries on its workers, NULL for one at a time
+//--------------------------------------------------------------
+void CountryFill::setup(const vector<vv_geojson::Country> & countries, TaskScheduler * scheduler){
+
+    uint64_t start_time = ofGetElapsedTimeMicros();
+
+    _num_countries = countries.size();
+    vector <CountryMesh> meshes(_num_countries);
+
+    // small chunks, so the big countries don't end up all in the same one;
+    // background, so the main thread doesn't take them while it runs a frame
+    if (scheduler != NULL){
+        scheduler->parallel_for(0, _num_countries, 4, [&countries, &meshes](int from, int to){
+            tessellate(&countries, from, to, &meshes);
+        }, true);
+    }
+    else tessellate(&countries, 0, _num_countries, &meshes);
+
+    // pack them, the country index goes in the texture coordinates
+    _vertices.clear();
+    _tex_coords.clear();
+    _indices.clear();
+    _names.clear();
+
+    for (int c = 0; c < _num_countries; c++){
+
+        uint32_t first_vertex = _vertices.size() / 2;
+        float s = (c + 0.5f) / _num_countries;
+
+        _vertices.insert(_vertices.end(), meshes[c].vertices.begin(), meshes[c].vertices.end());
+        _tex_coords.insert(_tex_coords.end(), meshes[c].vertices.size() / 2, s);
+        for (int i = 0; i < meshes[c].indices.size(); i++){
+            _indices.push_back(first_vertex + meshes[c].indices[i]);
+        }
+
+        if (!countries[c].name.empty()) _names[countries[c].name] = c;
+        if (!countries[c].long_name.empty()) _names[countries[c].long_name] = c;
+        // the first country of a sovereignty stands for it
+        if (!countries[c].sovereignty.empty() && _names.count(countries[c].sovereignty) == 0) _names[countries[c].sovereignty] = c;
+    }
+
+    _num_triangles = _indices.size() / 3;
+    _activity.assign(_num_countries, 0);
+    _colors.assign(_num_countries * 4, 0);
+
+    _tessellation_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+// runs on the workers of the scheduler given to setup(), every call writes only its own range of meshes
+//--------------------------------------------------------------
+void CountryFill::tessellate(const vector<vv_geojson::Country> * countries, int from, int to, vector<CountryMesh> * meshes){
+
+    // ofPath shares its tessellator, this one is only for this thread
+    ofTessellator tessellator;
+
+    for (int c = from; c < to; c++){
+
+        CountryMesh & country_mesh = meshes->at(c);
+        const vv_geojson::Country & country = countries->at(c);
+
+        for (int p = 0; p < country.polygons.size(); p++){
+
+            ofMesh mesh;
+            tessellator.tessellateToMesh(country.polygons[p], OF_POLY_WINDING_ODD, mesh, true);
+
+            uint32_t first_vertex = country_mesh.vertices.size() / 2;
+            const vector <ofVec3f> & vertices = mesh.getVertices();
+            for (int v = 0; v < vertices.size(); v++){
+                country_mesh.vertices.push_back(vertices[v].x);
+                country_mesh.vertices.push_back(vertices[v].y);
+            }
+            const vector <ofIndexType> & indices = mesh.getIndices();
+            for (int i = 0; i < indices.size(); i++){
+                country_mesh.indices.push_back(first_vertex + indices[i]);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void CountryFill::upload(){
+    upload_slice(std::numeric_limits<size_t>::max());
+}
+
+//--------------------------------------------------------------
+// @desc:   the first slice allocates the buffers and the texture, every
+//          slice after that copies the next max_bytes into the buffers;
+//          nothing should be drawn until the last one
+// @return: true once everything is on the gpu
+//--------------------------------------------------------------
+bool CountryFill::upload_slice(size_t max_bytes){
+
+    GLenum targets[3] = {GL_ARRAY_BUFFER, GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER};
+    GLuint * buffers[3] = {&_vertex_buffer, &_tex_coord_buffer, &_index_buffer};
+    const char * data[3] = {(const char *) _vertices.data(), (const char *) _tex_coords.data(), (const char *) _indices.data()};
+    size_t sizes[3] = {_vertices.size() * sizeof(float), _tex_coords.size() * sizeof(float), _indices.size() * sizeof(uint32_t)};
+
+    if (_uploaded_bytes == 0){
+        for (int b = 0; b < 3; b++){
+            if (*buffers[b] == 0) glGenBuffers(1, buffers[b]);
+            glBindBuffer(targets[b], *buffers[b]);
+            glBufferData(targets[b], sizes[b], NULL, GL_STATIC_DRAW);
+            glBindBuffer(targets[b], 0);
+        }
+
+        // one pixel per country, nearest so that neighbours never mix
+        if (_texture == 0) glGenTextures(1, &_texture);
+        glBindTexture(GL_TEXTURE_2D, _texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, std::max(1, _num_countries), 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, _colors.empty() ? NULL : &_colors[0]);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    size_t start = 0; // of this buffer, as if they were a single array
+    for (int b = 0; b < 3; b++){
+        if (max_bytes > 0 && _uploaded_bytes < start + sizes[b]){
+            size_t from = _uploaded_bytes - start;
+            size_t bytes = std::min(sizes[b] - from, max_bytes);
+            glBindBuffer(targets[b], *buffers[b]);
+            glBufferSubData(targets[b], from, bytes, data[b] + from);
+            glBindBuffer(targets[b], 0);
+            _uploaded_bytes += bytes;
+            max_bytes -= bytes;
+        }
+        start += sizes[b];
+    }
+    if (_uploaded_bytes < start) return false;
+
+    // the cpu copies are not needed anymore
+    vector <float>().swap(_vertices);
+    vector <float>().swap(_tex_coords);
+    vector <uint32_t>().swap(_indices);
+    return true;
+}
+
+//--------------------------------------------------------------
+// @args:   dt: seconds since the last frame
+//--------------------------------------------------------------
+void CountryFill::update(float dt){
+
+    if (_texture == 0) return;
+
+    decay(dt);
+    upload_colors();
+}
+
+//--------------------------------------------------------------
+void CountryFill::decay(float dt){
+
+    float decay = pow(0.5f, dt / activity_half_life);
+    unsigned char r = color.r * 255, g = color.g * 255, b = color.b * 255;
+
+    for (int c = 0; c < _num_countries; c++){
+        _activity[c] *= decay;
+        float amount = std::min(1.0f, _activity[c] / saturation_activity);
+        _colors[c * 4 + 0] = r;
+        _colors[c * 4 + 1] = g;
+        _colors[c * 4 + 2] = b;
+        _colors[c * 4 + 3] = amount * color.a * 255;
+    }
+}
+
+//--------------------------------------------------------------
+void CountryFill::upload_colors(){
+
+    if (_texture == 0) return;
+
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _num_countries, 1, GL_RGBA, GL_UNSIGNED_BYTE, &_colors[0]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//--------------------------------------------------------------
+void CountryFill::draw(){
+
+    if (_vertex_buffer == 0 || _num_triangles == 0) return;
+
+    ofPushStyle();
+    ofPushMatrix();
+    // just under the outlines
+    ofTranslate(0, 0, -0.02f);
+    ofSetColor(255);
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, _texture);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _tex_coord_buffer);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(1, GL_FLOAT, 0, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    glDrawElements(GL_TRIANGLES, _num_triangles * 3, GL_UNSIGNED_INT, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+
+    ofPopMatrix();
+    ofPopStyle();
+}
+
+//--------------------------------------------------------------
+void CountryFill::clear(){
+
+    if (_vertex_buffer != 0) glDeleteBuffers(1, &_vertex_buffer);
+    if (_tex_coord_buffer != 0) glDeleteBuffers(1, &_tex_coord_buffer);
+    if (_index_buffer != 0) glDeleteBuffers(1, &_index_buffer);
+    if (_texture != 0) glDeleteTextures(1, &_texture);
+    _vertex_buffer = 0;
+    _tex_coord_buffer = 0;
+    _index_buffer = 0;
+    _texture = 0;
+    _uploaded_bytes = 0;
+
+    _num_countries = 0;
+    _num_triangles = 0;
+    _names.clear();
+    _vertices.clear();
+    _tex_coords.clear();
+    _indices.clear();
+    _activity.clear();
+    _colors.clear();
+}
+
+//--------------------------------------------------------------
+int CountryFill::find_country(std::string name){
+    std::map <std::string, int>::iterator it = _names.find(name);
+    return it == _names.end() ? -1 : it->second;
+}
+
+//--------------------------------------------------------------
+void CountryFill::notify_activity(int country){
+    if (country < 0 || country >= _activity.size()) return;
+    _activity[country] += 1;
+}
+
+//--------------------------------------------------------------
+int CountryFill::get_num_countries(){
+    return _num_countries;
+}
+
+//--------------------------------------------------------------
+int CountryFill::get_num_triangles(){
+    return _num_triangles;
+}
+
+//--------------------------------------------------------------
+size_t CountryFill::get_bytes(){
+    return (_vertices.capacity() + _tex_coords.capacity() + _activity.capacity()) * sizeof(float) + 
+        _indices.capacity() * sizeof(uint32_t) + _colors.capacity();
+}
+
+//--------------------------------------------------------------
+float CountryFill::get_tessellation_ms(){
+    return _tessellation_ms;
+}
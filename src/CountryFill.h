@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_geojson.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+// Countries filled by how much they've been tweeted about lately.
+// Every country is tessellated only once, at load time (in parallel, each
+// thread with its own tessellator), and all the triangles live in a single
+// static gpu buffer. Every vertex carries the index of its country as a
+// texture coordinate, and the colors come from a texture one pixel per
+// country: a frame only decays the activities and uploads that tiny
+// texture, the cost depends on the countries and not on the vertices.
+//--------------------------------------------------------------
+
+class CountryFill {
+
+    public:
+
+        CountryFill();
+        ~CountryFill();
+
+        void setup(const vector<vv_geojson::Country> & countries, TaskScheduler * scheduler = NULL); // no gl calls, can run on a loader thread
+        void upload(); // needs the gl context
+        bool upload_slice(size_t max_bytes); // the same a few bytes at a time, true once all is uploaded
+        void update(float dt); // decays the activity, streams the colors
+        void decay(float dt); // the first half of update(), no gl calls
+        void upload_colors(); // the second one
+        void draw(); // inside cam.begin()/end(), under the outlines
+        void clear();
+
+        int find_country(std::string name); // -1 if none
+        void notify_activity(int country); // a tweet arrived from this country
+
+        int get_num_countries();
+        int get_num_triangles();
+        size_t get_bytes();
+        float get_tessellation_ms();
+
+        ofFloatColor color; // of the busiest countries
+        float activity_half_life; // seconds
+        float saturation_activity; // the activity that gets the full color
+
+    private:
+
+        struct CountryMesh {
+            vector <float> vertices; // x, y
+            vector <uint32_t> indices;
+        };
+
+        static void tessellate(const vector<vv_geojson::Country> * countries, int from, int to, vector<CountryMesh> * meshes);
+
+        int _num_countries, _num_triangles;
+        std::map <std::string, int> _names; // any of the names of a country
+
+        // one entry per vertex
+        vector <float> _vertices; // x, y
+        vector <float> _tex_coords; // index of the country, in texture coordinates
+        vector <uint32_t> _indices;
+
+        // one entry per country
+        vector <float> _activity;
+        vector <unsigned char> _colors; // rgba, streamed every frame
+
+        GLuint _vertex_buffer, _tex_coord_buffer, _index_buffer, _texture;
+        size_t _uploaded_bytes; // vertices, tex coords and indices, in this order
+        float _tessellation_ms;
+};
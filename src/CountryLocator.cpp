@@ -0,0 +1,301 @@
+#include "CountryLocator.h"
+
+// a point in a cell with more countries than this goes through find_exact()
+static const int MAX_CELL_COUNTRIES = 16;
+
+//--------------------------------------------------------------
+// true if the segment p-q crosses the edge a-b: both ends of each one on
+// different sides of the other. Points exactly on a line count as on the
+// left, so a segment through a vertex crosses one of its two edges, not both.
+// In double: a center a hair away from an edge has to be on the same side
+// as it was for the scanline of setup(), or the whole cell flips.
+//--------------------------------------------------------------
+static inline bool left_of(double ax, double ay, double bx, double by, double px, double py){
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax) >= 0;
+}
+
+static inline bool crosses(double px, double py, double qx, double qy, double ax, double ay, double bx, double by){
+    return left_of(ax, ay, bx, by, px, py) != left_of(ax, ay, bx, by, qx, qy)
+        && left_of(px, py, qx, qy, ax, ay) != left_of(px, py, qx, qy, bx, by);
+}
+
+//--------------------------------------------------------------
+CountryLocator::CountryLocator(){
+    clear();
+}
+
+//--------------------------------------------------------------
+// @args:   countries: their rings on mercator, as filled by create_geojson_map()
+//          columns: of the grid, the rows follow from the shape of the map.
+//          More cells means fewer edges in each one, and more memory.
+//--------------------------------------------------------------
+void CountryLocator::setup(const vector<vv_geojson::Country> & countries, int columns){
+
+    clear();
+    uint64_t start_time = ofGetElapsedTimeMicros();
+
+    // the bounds of everything that isn't at infinity
+    _min_x = _min_y = FLT_MAX;
+    _max_x = _max_y = -FLT_MAX;
+    for (int c = 0; c < countries.size(); c++){
+        for (int p = 0; p < countries[c].polygons.size(); p++){
+            for (int r = 0; r < countries[c].polygons[p].size(); r++){
+                const vector <ofPoint> & ring = countries[c].polygons[p][r].getVertices();
+                for (int v = 0; v < ring.size(); v++){
+                    if (!std::isfinite(ring[v].x) || !std::isfinite(ring[v].y)) continue;
+                    _min_x = std::min(_min_x, ring[v].x);
+                    _max_x = std::max(_max_x, ring[v].x);
+                    _min_y = std::min(_min_y, ring[v].y);
+                    _max_y = std::max(_max_y, ring[v].y);
+                }
+            }
+        }
+    }
+    if (_min_x >= _max_x || _min_y >= _max_y) return;
+
+    // mercator is square at 85 degrees, whatever is further north or south is squashed on the border
+    float half_width = (_max_x - _min_x) / 2;
+    _min_y = std::max(_min_y, -half_width);
+    _max_y = std::min(_max_y, half_width);
+
+    _columns = std::max(1, columns);
+    _cell_size = (_max_x - _min_x) / _columns;
+    _rows = std::max(1, int(ceil((_max_y - _min_y) / _cell_size)));
+
+    // EDGES
+    // every edge of every ring, holes included, the rings are closed here
+    for (int c = 0; c < countries.size(); c++){
+        _names.push_back(countries[c].name);
+        for (int p = 0; p < countries[c].polygons.size(); p++){
+            for (int r = 0; r < countries[c].polygons[p].size(); r++){
+                const vector <ofPoint> & ring = countries[c].polygons[p][r].getVertices();
+                for (int v = 0; v < ring.size(); v++){
+                    if (std::isnan(ring[v].x) || std::isnan(ring[v].y)) break;
+                    ofVec2f a = clamp(ring[v]);
+                    ofVec2f b = clamp(ring[(v + 1) % ring.size()]);
+                    if (a == b) continue;
+                    Edge edge = {a.x, a.y, b.x, b.y, c};
+                    _edges.push_back(edge);
+                }
+            }
+        }
+    }
+
+    // the cells each edge goes through (a little more than that, to be safe on the borders),
+    // and the rows, for the centers
+    int num_cells = _columns * _rows;
+    vector <vector<uint32_t> > cell_edges(num_cells), row_edges(_rows);
+    float margin = _cell_size * 0.001f;
+    for (uint32_t e = 0; e < _edges.size(); e++){
+
+        const Edge & edge = _edges[e];
+        float low = std::min(edge.ay, edge.by), high = std::max(edge.ay, edge.by);
+        int first_row = ofClamp(floor((low - margin - _min_y) / _cell_size), 0, _rows - 1);
+        int last_row = ofClamp(floor((high + margin - _min_y) / _cell_size), 0, _rows - 1);
+
+        for (int row = first_row; row <= last_row; row++){
+
+            row_edges[row].push_back(e);
+
+            // the part of the edge inside this row
+            float x0, x1;
+            if (edge.ay == edge.by){
+                x0 = std::min(edge.ax, edge.bx);
+                x1 = std::max(edge.ax, edge.bx);
+            }
+            else {
+                float y0 = std::max(low, _min_y + row * _cell_size - margin);
+                float y1 = std::min(high, _min_y + (row + 1) * _cell_size + margin);
+                float t0 = (y0 - edge.ay) / (edge.by - edge.ay), t1 = (y1 - edge.ay) / (edge.by - edge.ay);
+                x0 = edge.ax + ofClamp(t0, 0, 1) * (edge.bx - edge.ax);
+                x1 = edge.ax + ofClamp(t1, 0, 1) * (edge.bx - edge.ax);
+                if (x0 > x1) std::swap(x0, x1);
+            }
+            int first_column = ofClamp(floor((x0 - margin - _min_x) / _cell_size), 0, _columns - 1);
+            int last_column = ofClamp(floor((x1 + margin - _min_x) / _cell_size), 0, _columns - 1);
+            for (int column = first_column; column <= last_column; column++){
+                cell_edges[row * _columns + column].push_back(e);
+            }
+        }
+    }
+
+    // CENTERS
+    // a horizontal line through the centers of each row: going left to right,
+    // every edge it crosses gets us in or out of that edge's country
+    _cell_country.assign(num_cells, -1);
+    vector <char> inside(countries.size(), 0);
+    vector <int> inside_list;
+    vector <std::pair<double, int> > crossings;
+    for (int row = 0; row < _rows; row++){
+
+        float y = _min_y + (row + 0.5f) * _cell_size;
+        crossings.clear();
+        for (int i = 0; i < row_edges[row].size(); i++){
+            const Edge & edge = _edges[row_edges[row][i]];
+            if ((edge.ay > y) == (edge.by > y)) continue;
+            double x = edge.ax + (double(y) - edge.ay) * (double(edge.bx) - edge.ax) / (double(edge.by) - edge.ay);
+            crossings.push_back(std::make_pair(x, edge.country));
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        int next = 0;
+        for (int column = 0; column < _columns; column++){
+            float x = _min_x + (column + 0.5f) * _cell_size;
+            for (; next < crossings.size() && crossings[next].first < x; next++){
+                int country = crossings[next].second;
+                inside[country] = !inside[country];
+                if (inside[country]) inside_list.push_back(country);
+                else inside_list.erase(std::find(inside_list.begin(), inside_list.end(), country));
+            }
+            // overlapping countries (disputed areas) go to the first one in
+            if (!inside_list.empty()) _cell_country[row * _columns + column] = inside_list.front();
+        }
+        for (int i = 0; i < inside_list.size(); i++) inside[inside_list[i]] = 0;
+        inside_list.clear();
+    }
+
+    // and all the edges of the cells in a single array
+    _cell_start.resize(num_cells + 1);
+    _cell_start[0] = 0;
+    for (int c = 0; c < num_cells; c++){
+        _cell_start[c + 1] = _cell_start[c] + cell_edges[c].size();
+        if (!cell_edges[c].empty()) _num_boundary_cells++;
+    }
+    _cell_edges.reserve(_cell_start[num_cells]);
+    for (int c = 0; c < num_cells; c++){
+        _cell_edges.insert(_cell_edges.end(), cell_edges[c].begin(), cell_edges[c].end());
+    }
+
+    _build_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void CountryLocator::clear(){
+
+    _names.clear();
+    _edges.clear();
+    _cell_country.clear();
+    _cell_start.clear();
+    _cell_edges.clear();
+    _min_x = _min_y = _max_x = _max_y = 0;
+    _cell_size = 1;
+    _columns = _rows = 0;
+    _num_boundary_cells = 0;
+    _build_ms = 0;
+}
+
+//--------------------------------------------------------------
+// @desc:   the country of the center of the cell, flipped by every edge
+//          between the center and the point
+//--------------------------------------------------------------
+int CountryLocator::find(const ofPoint & position) const{
+
+    if (_columns == 0 || !(position.x >= _min_x && position.x <= _max_x) || std::isnan(position.y)) return -1;
+    ofVec2f point = clamp(position);
+
+    int column = std::min(_columns - 1, int((point.x - _min_x) / _cell_size));
+    int row = std::min(_rows - 1, int((point.y - _min_y) / _cell_size));
+    int cell = row * _columns + column;
+
+    uint32_t begin = _cell_start[cell], end = _cell_start[cell + 1];
+    if (begin == end) return _cell_country[cell];
+
+    float center_x = _min_x + (column + 0.5f) * _cell_size;
+    float center_y = _min_y + (row + 0.5f) * _cell_size;
+
+    // the countries around, and whether the point is in them
+    int countries[MAX_CELL_COUNTRIES];
+    bool inside[MAX_CELL_COUNTRIES];
+    int num_countries = 0;
+    if (_cell_country[cell] >= 0){
+        countries[0] = _cell_country[cell];
+        inside[0] = true;
+        num_countries = 1;
+    }
+
+    for (uint32_t i = begin; i < end; i++){
+
+        const Edge & edge = _edges[_cell_edges[i]];
+        if (!crosses(center_x, center_y, point.x, point.y, edge.ax, edge.ay, edge.bx, edge.by)) continue;
+
+        int c = 0;
+        while (c < num_countries && countries[c] != edge.country) c++;
+        if (c == num_countries){
+            if (num_countries == MAX_CELL_COUNTRIES) return find_exact(position);
+            countries[c] = edge.country;
+            inside[c] = false;
+            num_countries++;
+        }
+        inside[c] = !inside[c];
+    }
+
+    for (int c = 0; c < num_countries; c++){
+        if (inside[c]) return countries[c];
+    }
+    return -1;
+}
+
+//--------------------------------------------------------------
+// @desc:   the usual ray crossing test, a ray to the left against every edge
+//--------------------------------------------------------------
+int CountryLocator::find_exact(const ofPoint & position) const{
+
+    if (_columns == 0 || !(position.x >= _min_x && position.x <= _max_x) || std::isnan(position.y)) return -1;
+    ofVec2f point = clamp(position);
+
+    int country = -1;
+    bool inside = false;
+    for (int e = 0; e < _edges.size(); e++){
+
+        const Edge & edge = _edges[e];
+        if (edge.country != country){
+            if (inside) return country;
+            country = edge.country;
+            inside = false;
+        }
+        if ((edge.ay > point.y) == (edge.by > point.y)) continue;
+        float x = edge.ax + (point.y - edge.ay) * (edge.bx - edge.ax) / (edge.by - edge.ay);
+        if (x < point.x) inside = !inside;
+    }
+    return inside ? country : -1;
+}
+
+//--------------------------------------------------------------
+std::string CountryLocator::get_name(int country) const{
+    return country >= 0 && country < _names.size() ? _names[country] : "";
+}
+
+//--------------------------------------------------------------
+int CountryLocator::get_num_countries(){
+    return _names.size();
+}
+
+//--------------------------------------------------------------
+int CountryLocator::get_num_cells(){
+    return _columns * _rows;
+}
+
+//--------------------------------------------------------------
+float CountryLocator::get_boundary_ratio(){
+    return _columns * _rows > 0 ? _num_boundary_cells / float(_columns * _rows) : 0;
+}
+
+//--------------------------------------------------------------
+size_t CountryLocator::get_bytes(){
+
+    size_t bytes = _edges.capacity() * sizeof(Edge);
+    bytes += _cell_country.capacity() * sizeof(int);
+    bytes += (_cell_start.capacity() + _cell_edges.capacity()) * sizeof(uint32_t);
+    for (int n = 0; n < _names.size(); n++) bytes += _names[n].capacity();
+    return bytes;
+}
+
+//--------------------------------------------------------------
+float CountryLocator::get_build_ms(){
+    return _build_ms;
+}
+
+//--------------------------------------------------------------
+ofVec2f CountryLocator::clamp(const ofPoint & position) const{
+    return ofVec2f(ofClamp(position.x, _min_x, _max_x), ofClamp(position.y, _min_y, _max_y));
+}
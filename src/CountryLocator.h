@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_geojson.h"
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// Which country a point of the map is in, from the same rings as CountryFill
+// (so the indices are the same), for the tweets that come with coordinates
+// but with a missing or wrong nation.
+// The map is cut in a grid of square cells. Every cell knows the country of
+// its center and the country edges that go through it: a point in a cell
+// with no edges is in the country of the center, that's most of them and
+// it's a lookup. Otherwise a segment goes from the center to the point, and
+// every edge it crosses flips whether the point is in that edge's country,
+// the ray crossing test but only with the few edges of that cell.
+//
+// @example:
+//
+// CountryLocator locator;
+// locator.setup(countries); // as filled by create_geojson_map()
+// int country = locator.find(vv_map_projections::mercator(lon, lat, scale));
+// if (country >= 0) cout << locator.get_name(country) << endl;
+//--------------------------------------------------------------
+
+class CountryLocator {
+
+    public:
+
+        CountryLocator();
+
+        void setup(const vector<vv_geojson::Country> & countries, int columns = 512); // no gl calls, can run on a loader thread
+        void clear();
+
+        int find(const ofPoint & position) const; // on mercator, -1 in the sea
+        int find_exact(const ofPoint & position) const; // through every ring, to check find()
+        std::string get_name(int country) const;
+
+        int get_num_countries();
+        int get_num_cells();
+        float get_boundary_ratio(); // cells with edges in them, the ones that need the crossing test
+        size_t get_bytes();
+        float get_build_ms();
+
+    private:
+
+        struct Edge {
+            float ax, ay, bx, by;
+            int country;
+        };
+
+        ofVec2f clamp(const ofPoint & position) const; // into the grid, the poles are at infinity on mercator
+
+        vector <std::string> _names;
+        vector <Edge> _edges;
+
+        // one entry per cell, row by row
+        vector <int> _cell_country; // of the center of the cell, -1 for the sea
+        vector <uint32_t> _cell_start; // the edges of cell c are _cell_edges[_cell_start[c]] to _cell_edges[_cell_start[c + 1]]
+        vector <uint32_t> _cell_edges; // indices in _edges
+
+        float _min_x, _min_y, _max_x, _max_y, _cell_size;
+        int _columns, _rows, _num_boundary_cells;
+        float _build_ms;
+};
@@ -0,0 +1,112 @@
+#include "DensityLayer.h"
+
+//--------------------------------------------------------------
+// @args:   bounds: the area of the map covered, in map coordinates
+//          cols, rows: resolution of the grid
+//          half_life: seconds after which a tweet counts half
+//--------------------------------------------------------------
+void DensityLayer::setup(ofRectangle bounds, int cols, int rows, float half_life){
+
+    _bounds = bounds;
+    _cols = cols;
+    _rows = rows;
+    _half_life = half_life;
+
+    color = ofColor(255, 40, 0);
+    saturation = 2;
+
+    _grid.assign(cols * rows, 0);
+    _pixels.allocate(cols, rows, OF_IMAGE_COLOR_ALPHA);
+    _texture.allocate(_pixels);
+    _texture.setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+
+    clear();
+}
+
+//--------------------------------------------------------------
+void DensityLayer::add(ofPoint position, float weight){
+
+    // position in cells, with the cell centers at integer coordinates
+    float gx = (position.x - _bounds.x) / _bounds.width * _cols - 0.5f;
+    float gy = (position.y - _bounds.y) / _bounds.height * _rows - 0.5f;
+    if (gx < 0 || gy < 0 || gx >= _cols - 1 || gy >= _rows - 1) return;
+
+    int x = gx;
+    int y = gy;
+    float fx = gx - x;
+    float fy = gy - y;
+
+    float * cell = &_grid[y * _cols + x];
+    cell[0]         += weight * (1 - fx) * (1 - fy);
+    cell[1]         += weight * fx * (1 - fy);
+    cell[_cols]     += weight * (1 - fx) * fy;
+    cell[_cols + 1] += weight * fx * fy;
+}
+
+//--------------------------------------------------------------
+void DensityLayer::update(float dt){
+    decay(dt);
+    upload();
+}
+
+//--------------------------------------------------------------
+void DensityLayer::decay(float dt){
+
+    const float decay = pow(0.5f, dt / _half_life);
+    const float inv_saturation = 1.0f / saturation;
+    const int n = _cols * _rows;
+
+    float * __restrict grid = &_grid[0];
+    unsigned char * __restrict pixels = _pixels.getData();
+
+    // decay, then tone map: both loops are branch free so they vectorize
+    for (int i = 0; i < n; i++){
+        grid[i] *= decay;
+    }
+    for (int i = 0; i < n; i++){
+        float v = grid[i] * inv_saturation;
+        // v / (1 + v) goes smoothly from 0 to 1, never saturating
+        pixels[i * 4 + 3] = (unsigned char) (255.0f * v / (1.0f + v));
+    }
+}
+
+//--------------------------------------------------------------
+void DensityLayer::upload(){
+    _texture.loadData(_pixels);
+}
+
+//--------------------------------------------------------------
+// call this inside cam.begin(), before the outlines
+//--------------------------------------------------------------
+void DensityLayer::draw(){
+
+    ofPushStyle();
+    ofSetColor(255);
+    ofPushMatrix();
+    // just below the outlines
+    ofTranslate(0, 0, -0.05f);
+    _texture.draw(_bounds.x, _bounds.y, _bounds.width, _bounds.height);
+    ofPopMatrix();
+    ofPopStyle();
+}
+
+//--------------------------------------------------------------
+void DensityLayer::clear(){
+
+    std::fill(_grid.begin(), _grid.end(), 0.0f);
+
+    // only the alpha changes from now on
+    unsigned char * pixels = _pixels.getData();
+    for (int i = 0; i < _cols * _rows; i++){
+        pixels[i * 4 + 0] = color.r;
+        pixels[i * 4 + 1] = color.g;
+        pixels[i * 4 + 2] = color.b;
+        pixels[i * 4 + 3] = 0;
+    }
+    _texture.loadData(_pixels);
+}
+
+//--------------------------------------------------------------
+size_t DensityLayer::get_bytes(){
+    return _grid.capacity() * sizeof(float) + _pixels.getTotalBytes();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+
+//--------------------------------------------------------------
+// Tweet density over the mercator plane, fading out over time.
+// add() splats one tweet in the grid (bilinear, 4 cells), so it's O(1);
+// update() decays the whole grid in a single flat loop and converts it to the
+// pixels of one texture, drawn under the outlines of the map.
+// The cost per frame only depends on the grid size, not on the number of tweets.
+//--------------------------------------------------------------
+
+class DensityLayer {
+
+    public:
+
+        void setup(ofRectangle bounds, int cols, int rows, float half_life);
+        void add(ofPoint position, float weight = 1);
+        void update(float dt); // dt in seconds, same as decay() then upload()
+        void decay(float dt); // no gl calls, can run on a worker
+        void upload(); // the pixels of the last decay()
+        void draw();
+        void clear();
+
+        size_t get_bytes();
+
+        ofColor color;
+        float saturation; // density that gets half of the max opacity
+
+    private:
+
+        ofRectangle _bounds;
+        int _cols, _rows;
+        float _half_life;
+
+        vector <float> _grid;
+        ofPixels _pixels;
+        ofTexture _texture;
+};
@@ -1,5 +1,7 @@
 #include "Firework.h"
 
+std::atomic<int> Firework::particles_per_explosion(30);
+
 //--------------------------------------------------------------
 void Firework::setup(ofPoint pos, ofFloatColor col){
     position = pos;
@@ -30,7 +32,8 @@ void Firework::update(){
         // when the particle reaches the top
         if (!_exploded){
 
-            for (int i = 0; i < 30; i++){
+            int num_particles = particles_per_explosion;
+            for (int i = 0; i < num_particles; i++){
                 FireworkParticle new_particle;
                 new_particle.setup(
                     initial_particle.position,
@@ -1,5 +1,7 @@
 #include "ofMain.h"
 #include "FireworkParticle.h"
+#include "vv_memory.h"
+#include <atomic>
 
 class Firework {
 
@@ -9,9 +11,11 @@ class Firework {
         void update();
         bool exploded();
 
+        static std::atomic<int> particles_per_explosion; // all of them (set by the QualityGovernor)
+
         // physics
         FireworkParticle initial_particle;
-        vector <FireworkParticle> particles;
+        vector <FireworkParticle, vv_memory::CountingAllocator<FireworkParticle, vv_memory::FIREWORK_PARTICLES> > particles;
         ofVec3f position;
         // shading
         ofColor color;
@@ -0,0 +1,180 @@
+#include "FrameProfiler.h"
+
+//--------------------------------------------------------------
+FrameProfiler::FrameProfiler(){
+
+    show_overlay = false;
+    _num_phases = 0;
+    _num_open = 0;
+    _last_frame_time = 0;
+    _write_index = 0;
+
+    for (int i = 0; i < RING_SIZE; i++) _ring_frames[i] = 0;
+
+    _frame_phase = add_phase("frame");
+}
+
+//--------------------------------------------------------------
+// @return: the id to use with ProfileScope, or -1 when there is no room left
+//--------------------------------------------------------------
+int FrameProfiler::add_phase(std::string name){
+
+    if (_num_phases >= MAX_PHASES) return -1;
+
+    Phase & phase = _phases[_num_phases];
+    phase.name = name;
+    phase.current = 0;
+    for (int i = 0; i < RING_SIZE; i++) phase.ring[i] = 0;
+    for (int b = 0; b < HISTOGRAM_BINS; b++) phase.histogram[b] = 0;
+
+    return _num_phases++;
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::add_sample(int phase, uint64_t micros){
+    if (phase < 0) return;
+    _phases[phase].current += micros;
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::begin(int phase){
+    if (phase < 0 || _num_open >= MAX_PHASES) return;
+    OpenPhase & open = _open[_num_open++];
+    open.phase = phase;
+    open.started = ofGetElapsedTimeMicros();
+    open.nested = 0;
+}
+
+//--------------------------------------------------------------
+// @desc:   counts only the time of the phase itself (exclusive time), the
+//          whole of it goes to the phase it was begun inside of
+//--------------------------------------------------------------
+void FrameProfiler::end(int phase){
+    if (phase < 0 || _num_open == 0 || _open[_num_open - 1].phase != phase) return;
+    OpenPhase & open = _open[--_num_open];
+    uint64_t elapsed = ofGetElapsedTimeMicros() - open.started;
+    add_sample(phase, elapsed - std::min(elapsed, open.nested));
+    if (_num_open > 0) _open[_num_open - 1].nested += elapsed;
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::end_frame(){
+
+    uint64_t now = ofGetElapsedTimeMicros();
+    if (_last_frame_time > 0) _phases[_frame_phase].current = now - _last_frame_time;
+    _last_frame_time = now;
+
+    uint32_t slot = _write_index.load(std::memory_order_relaxed) & (RING_SIZE - 1);
+
+    for (int p = 0; p < _num_phases; p++){
+
+        uint64_t micros = _phases[p].current;
+        _phases[p].ring[slot] = micros;
+
+        // log2 bin
+        int bin = 0;
+        while (micros > 0 && bin < HISTOGRAM_BINS - 1){
+            micros >>= 1;
+            bin++;
+        }
+        _phases[p].histogram[bin].fetch_add(1, std::memory_order_relaxed);
+
+        _phases[p].current = 0;
+    }
+    _ring_frames[slot] = ofGetFrameNum();
+
+    // publish the slot to the readers
+    _write_index.fetch_add(1, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+// @return: an estimate of the given percentile (0-100), interpolated inside the histogram bin
+//--------------------------------------------------------------
+float FrameProfiler::get_percentile(int phase, float percentile){
+
+    uint64_t counts[HISTOGRAM_BINS];
+    uint64_t total = 0;
+    for (int b = 0; b < HISTOGRAM_BINS; b++){
+        counts[b] = _phases[phase].histogram[b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+    if (total == 0) return 0;
+
+    uint64_t rank = ceil(total * percentile / 100.0f);
+    uint64_t seen = 0;
+    for (int b = 0; b < HISTOGRAM_BINS; b++){
+        if (seen + counts[b] >= rank){
+            float low = b == 0 ? 0 : float(1ull << (b - 1));
+            float high = float(1ull << b);
+            return ofMap(rank - seen, 0, counts[b], low, high, true);
+        }
+        seen += counts[b];
+    }
+    return float(1ull << (HISTOGRAM_BINS - 1));
+}
+
+//--------------------------------------------------------------
+float FrameProfiler::get_last(int phase){
+
+    uint32_t written = _write_index.load(std::memory_order_acquire);
+    if (written == 0) return 0;
+    return _phases[phase].ring[(written - 1) & (RING_SIZE - 1)];
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::draw(float x, float y){
+
+    if (!show_overlay) return;
+
+    std::stringstream overlay;
+    overlay << "phase          last    p50    p95    p99 (ms)\n";
+    for (int p = 0; p < _num_phases; p++){
+        char line[128];
+        snprintf(line, sizeof(line), "%-12s %6.2f %6.2f %6.2f %6.2f\n",
+            _phases[p].name.c_str(),
+            get_last(p) / 1000.0f,
+            get_percentile(p, 50) / 1000.0f,
+            get_percentile(p, 95) / 1000.0f,
+            get_percentile(p, 99) / 1000.0f);
+        overlay << line;
+    }
+
+    ofPushStyle();
+    ofDrawBitmapStringHighlight(overlay.str(), x, y, ofColor(0, 200), ofColor(255));
+    ofPopStyle();
+}
+
+//--------------------------------------------------------------
+// Writes the last RING_SIZE frames, one row per frame and one column per phase (micros),
+// followed by the percentiles of the whole run.
+//--------------------------------------------------------------
+bool FrameProfiler::dump_csv(std::string path){
+
+    ofstream file(ofToDataPath(path).c_str());
+    if (!file.is_open()) return false;
+
+    file << "frame";
+    for (int p = 0; p < _num_phases; p++) file << "," << _phases[p].name;
+    file << "\n";
+
+    uint32_t written = _write_index.load(std::memory_order_acquire);
+    uint32_t first = written > RING_SIZE ? written - RING_SIZE : 0;
+
+    for (uint32_t i = first; i < written; i++){
+        uint32_t slot = i & (RING_SIZE - 1);
+        file << _ring_frames[slot];
+        for (int p = 0; p < _num_phases; p++) file << "," << _phases[p].ring[slot];
+        file << "\n";
+    }
+
+    const float percentiles[] = {50, 95, 99};
+    for (int i = 0; i < 3; i++){
+        file << "p" << percentiles[i];
+        for (int p = 0; p < _num_phases; p++) file << "," << get_percentile(p, percentiles[i]);
+        file << "\n";
+    }
+
+    cout << "FrameProfiler: saved " << (written - first) << " frames to " << path << endl;
+
+    return true;
+}
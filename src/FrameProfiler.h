@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// Low overhead per phase frame timings.
+// Each phase of the frame is wrapped in a ProfileScope; the time spent inside
+// is summed over the frame and, at end_frame(), pushed in a lock-free ring buffer
+// (the last RING_SIZE frames, used for the csv) and in a log2 histogram
+// (used for p50/p95/p99, never reset so it covers the whole run).
+// Phases can nest: each one counts only its own time, the time of the phases
+// opened inside it goes to them, so the phases of a frame add up to the frame.
+// Only one thread writes, any thread can read.
+//
+// @example:
+//
+// int phase_osc = profiler.add_phase("osc");
+// ...
+// {
+//     ProfileScope scope(profiler, phase_osc);
+//     // do stuff
+// }
+// ...
+// profiler.begin(phase_draw);
+// // draw stuff
+// profiler.end(phase_draw);
+// ...
+// profiler.end_frame(); // at the end of ofApp::draw()
+//--------------------------------------------------------------
+
+class FrameProfiler {
+
+    public:
+
+        static const int MAX_PHASES = 16;
+        static const int RING_SIZE = 1024; // power of two
+        static const int HISTOGRAM_BINS = 32; // bin b counts samples in [2^(b-1), 2^b) micros
+
+        FrameProfiler();
+
+        int add_phase(std::string name);
+        void add_sample(int phase, uint64_t micros); // accumulated until end_frame(), measured somewhere else
+        void begin(int phase); // same as ProfileScope, for code that is not in its own block
+        void end(int phase); // the last phase begun must be the first to end
+        void end_frame();
+
+        float get_percentile(int phase, float percentile); // in micros, from the histogram
+        float get_last(int phase); // in micros
+
+        void draw(float x, float y);
+        bool dump_csv(std::string path);
+
+        bool show_overlay;
+
+    private:
+
+        struct Phase {
+            std::string name;
+            uint64_t current; // accumulated during the current frame
+            uint32_t ring[RING_SIZE];
+            std::atomic<uint64_t> histogram[HISTOGRAM_BINS];
+        };
+
+        // phases begun and not ended yet, the innermost last
+        struct OpenPhase {
+            int phase;
+            uint64_t started;
+            uint64_t nested; // time of the phases begun inside this one
+        };
+
+        Phase _phases[MAX_PHASES];
+        int _num_phases;
+        OpenPhase _open[MAX_PHASES];
+        int _num_open;
+        int _frame_phase; // total time between two end_frame() calls
+        uint64_t _last_frame_time;
+        uint64_t _ring_frames[RING_SIZE]; // frame number of each ring slot
+        std::atomic<uint32_t> _write_index;
+};
+
+//--------------------------------------------------------------
+class ProfileScope {
+
+    public:
+
+        ProfileScope(FrameProfiler & profiler, int phase) : _profiler(profiler), _phase(phase) {
+            _profiler.begin(_phase);
+        }
+
+        ~ProfileScope(){
+            _profiler.end(_phase);
+        }
+
+    private:
+
+        FrameProfiler & _profiler;
+        int _phase;
+};
@@ -0,0 +1,170 @@
+#include "GeoStore.h"
+
+//--------------------------------------------------------------
+GeoStore::GeoStore(){
+    _buffer = 0;
+    _buffer_size = 0;
+    _last_reproject_ms = 0;
+}
+
+//--------------------------------------------------------------
+GeoStore::~GeoStore(){
+    clear();
+}
+
+//--------------------------------------------------------------
+void GeoStore::begin_ring(){
+    _firsts.push_back(_lons.size());
+    _counts.push_back(0);
+}
+
+//--------------------------------------------------------------
+void GeoStore::add_vertex(float lon, float lat){
+
+    if (_counts.empty()) begin_ring();
+
+    _lons.push_back(ofDegToRad(lon));
+    _lats.push_back(ofDegToRad(lat));
+    _counts.back()++;
+}
+
+//--------------------------------------------------------------
+void GeoStore::add_point(float lon, float lat){
+    _point_lons.push_back(lon);
+    _point_lats.push_back(lat);
+}
+
+//--------------------------------------------------------------
+// @desc:   projects every vertex with the same formulas of vv_map_projections::mercator()
+//          and globe(), blended by t, then updates the gpu buffer in place.
+//          On the bundled dataset (~35k vertices) it takes well under a frame.
+// @args:   t: 0 mercator, 1 globe, anything in between while animating
+//          scale: the one given to create_geojson_map()
+//--------------------------------------------------------------
+void GeoStore::reproject(float t, float scale){
+
+    uint64_t start_time = ofGetElapsedTimeMicros();
+
+    int n = _lons.size();
+    _positions.resize(n * 3);
+
+    if (n > 0){
+
+        const float * lons = &_lons[0];
+        const float * lats = &_lats[0];
+        float * positions = &_positions[0];
+        float radius = scale / PI;
+        // the poles are at infinity on mercator, stop a bit before
+        float max_lat = ofDegToRad(89.5f);
+
+        for (int i = 0; i < n; i++){
+
+            float lon = lons[i];
+            float lat = std::min(max_lat, std::max(-max_lat, lats[i]));
+
+            // mercator
+            float mx = lon / PI * scale;
+            float my = log(tan(PI / 4.0f + lat / 2.0f)) / PI * scale;
+
+            // globe
+            float cos_lat = cos(lat);
+            float gx = radius * cos_lat * sin(lon);
+            float gy = radius * sin(lat);
+            float gz = radius * (cos_lat * cos(lon) - 1);
+
+            positions[i * 3 + 0] = mx + (gx - mx) * t;
+            positions[i * 3 + 1] = my + (gy - my) * t;
+            positions[i * 3 + 2] = gz * t;
+        }
+
+        // the buffer is allocated once, then only its content changes
+        size_t bytes = _positions.size() * sizeof(float);
+        if (_buffer == 0) glGenBuffers(1, &_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+        if (bytes != _buffer_size){
+            glBufferData(GL_ARRAY_BUFFER, bytes, positions, GL_DYNAMIC_DRAW);
+            _buffer_size = bytes;
+        }
+        else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, positions);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // the cities are a few hundred, no need for the batch
+    _point_positions.resize(_point_lons.size());
+    for (int p = 0; p < _point_lons.size(); p++){
+        _point_positions[p] = project(_point_lons[p], _point_lats[p], t, scale);
+    }
+
+    _last_reproject_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+void GeoStore::draw(){
+
+    if (_buffer == 0 || _firsts.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+    glMultiDrawArrays(GL_LINE_STRIP, &_firsts[0], &_counts[0], _firsts.size());
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//--------------------------------------------------------------
+void GeoStore::clear(){
+
+    if (_buffer != 0) glDeleteBuffers(1, &_buffer);
+    _buffer = 0;
+    _buffer_size = 0;
+
+    _lons.clear();
+    _lats.clear();
+    _firsts.clear();
+    _counts.clear();
+    _point_lons.clear();
+    _point_lats.clear();
+    _positions.clear();
+    _point_positions.clear();
+}
+
+//--------------------------------------------------------------
+ofPoint GeoStore::project(float lon, float lat, float t, float scale){
+
+    lat = ofClamp(lat, -89.5f, 89.5f);
+    ofPoint flat = vv_map_projections::mercator(lon, lat, scale);
+    ofPoint round = vv_map_projections::globe(lon, lat, scale);
+    return flat + (round - flat) * t;
+}
+
+//--------------------------------------------------------------
+// @desc:   like get_point_positions()[index], but for any t: only reads the
+//          coordinates, which never change after loading
+//--------------------------------------------------------------
+ofPoint GeoStore::project_point(int index, float t, float scale){
+    return project(_point_lons[index], _point_lats[index], t, scale);
+}
+
+//--------------------------------------------------------------
+const vector <ofPoint> & GeoStore::get_point_positions(){
+    return _point_positions;
+}
+
+//--------------------------------------------------------------
+int GeoStore::get_num_vertices(){
+    return _lons.size();
+}
+
+//--------------------------------------------------------------
+size_t GeoStore::get_bytes(){
+    return (_lons.capacity() + _lats.capacity() + _point_lons.capacity() + _point_lats.capacity() + _positions.capacity()) * sizeof(float) + 
+        _firsts.capacity() * sizeof(GLint) + _counts.capacity() * sizeof(GLsizei) + 
+        _point_positions.capacity() * sizeof(ofPoint);
+}
+
+//--------------------------------------------------------------
+float GeoStore::get_last_reproject_ms(){
+    return _last_reproject_ms;
+}
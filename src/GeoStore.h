@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_map_projections.h"
+
+//--------------------------------------------------------------
+// The map as it comes from the geojson, before any projection: longitude
+// and latitude of every ring vertex (and of every city) kept as structure
+// of arrays, so that switching between the mercator map and the globe
+// doesn't mean parsing the file again.
+// reproject() is a single batch over all the vertices that writes into the
+// same gpu buffer every time; t blends between the two projections
+// (0 mercator, 1 globe) so the switch can be animated.
+//
+// @example:
+//
+// void ofApp::update(){
+//     store.reproject(projection_t, geojson_scale); // only when t changed
+// }
+//
+// void ofApp::draw(){
+//     store.draw(); // inside cam.begin()/end()
+// }
+//--------------------------------------------------------------
+
+class GeoStore {
+
+    public:
+
+        GeoStore();
+        ~GeoStore();
+
+        // filled by vv_geojson::create_geojson_map(), from any thread
+        void begin_ring();
+        void add_vertex(float lon, float lat); // degrees, to the last ring
+        void add_point(float lon, float lat); // degrees, one per city
+
+        void reproject(float t, float scale); // needs the gl context
+        void draw();
+        void clear();
+
+        // a single point, the same way reproject() does it
+        static ofPoint project(float lon, float lat, float t, float scale);
+        ofPoint project_point(int index, float t, float scale); // a city, from any thread once filled
+
+        const vector <ofPoint> & get_point_positions(); // as of the last reproject()
+        int get_num_vertices();
+        size_t get_bytes();
+        float get_last_reproject_ms();
+
+    private:
+
+        // ring vertices, in radians
+        vector <float> _lons, _lats;
+        vector <GLint> _firsts; // one line strip per ring
+        vector <GLsizei> _counts;
+        // cities, in degrees
+        vector <float> _point_lons, _point_lats;
+
+        vector <float> _positions; // x, y, z per vertex, reused by every reproject()
+        vector <ofPoint> _point_positions;
+        GLuint _buffer;
+        size_t _buffer_size; // in bytes, allocated once
+        float _last_reproject_ms;
+};
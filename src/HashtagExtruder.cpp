@@ -0,0 +1,190 @@
+#include "HashtagExtruder.h"
+
+namespace {
+
+    //--------------------------------------------------------------
+    // the sides come out of extrude_mesh_from_text() as triangle strips,
+    // QuantizedGeometry wants indexed triangles for everything that is not a line
+    //--------------------------------------------------------------
+    void strip_to_triangles(ofMesh & mesh){
+
+        if (mesh.getMode() != OF_PRIMITIVE_TRIANGLE_STRIP) return;
+
+        vector <ofIndexType> indices;
+        for (int v = 0; v + 2 < mesh.getNumVertices(); v++){
+            indices.push_back(v);
+            indices.push_back(v + 1);
+            indices.push_back(v + 2);
+        }
+        mesh.clearIndices();
+        mesh.addIndices(indices);
+        mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    }
+}
+
+//--------------------------------------------------------------
+// @args:   font: loaded with makeContours = true, it must outlive the extruder
+//          text_scale, extrusion_depth: see extrude_mesh_from_text()
+//--------------------------------------------------------------
+void HashtagExtruder::setup(ofTrueTypeFont & font, float text_scale, float extrusion_depth){
+
+    _font = &font;
+    _text_scale = text_scale;
+    _extrusion_depth = extrusion_depth;
+    _stats = HashtagExtruderStats();
+
+    upload_budget = 64 * 1024;
+    max_pending = 8;
+    max_alive = 12;
+    lifetime = 8;
+    rise_speed = 1.5f;
+
+    startThread();
+}
+
+//--------------------------------------------------------------
+void HashtagExtruder::add(std::string text, ofPoint position){
+
+    if (text.empty()) return;
+
+    Job job;
+    // long ones are not readable anyway
+    job.text = text.substr(0, 32);
+    job.position = position;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // during bursts the newest tweets win
+    if (_jobs.size() >= max_pending){
+        _jobs.pop_front();
+        _stats.dropped++;
+    }
+    _jobs.push_back(job);
+    _condition.notify_one();
+}
+
+//--------------------------------------------------------------
+void HashtagExtruder::update(){
+
+    float now = ofGetElapsedTimef();
+
+    // 1. the old ones have floated away
+    while (!_alive.empty() && now - _alive.front().birth_time > lifetime){
+        _alive.pop_front();
+    }
+
+    // 2. upload what the worker finished, within the budget
+    _stats.uploaded_bytes = 0;
+    while (_stats.uploaded_bytes == 0 || _stats.uploaded_bytes < upload_budget){
+
+        Hashtag hashtag;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (_ready.empty()) break;
+            hashtag = _ready.front();
+            _ready.pop_front();
+        }
+
+        hashtag.geometry->upload();
+        _stats.uploaded_bytes += hashtag.geometry->get_gpu_bytes();
+        // they start floating when they show up, not when they were tweeted
+        hashtag.birth_time = now;
+
+        if (_alive.size() >= max_alive) _alive.pop_front();
+        _alive.push_back(hashtag);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    _stats.pending = _jobs.size();
+    _stats.ready = _ready.size();
+    _stats.alive = _alive.size();
+}
+
+//--------------------------------------------------------------
+void HashtagExtruder::draw(){
+
+    float now = ofGetElapsedTimef();
+
+    ofPushStyle();
+    for (int h = 0; h < _alive.size(); h++){
+
+        Hashtag & hashtag = _alive[h];
+        float age = now - hashtag.birth_time;
+
+        // fade in quickly, fade out during the last third of its life
+        float alpha = std::min(ofMap(age, 0, 0.5f, 0, 1, true), ofMap(age, lifetime * 0.66f, lifetime, 1, 0, true));
+        ofSetColor(0, alpha * 255);
+
+        // standing up over the city, like the labels
+        ofPushMatrix();
+        ofTranslate(hashtag.position);
+        ofTranslate(-hashtag.width * 0.5f, 0, 1 + age * rise_speed);
+        ofRotateX(-90);
+        hashtag.geometry->draw_all();
+        ofPopMatrix();
+    }
+    ofPopStyle();
+}
+
+//--------------------------------------------------------------
+void HashtagExtruder::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopThread();
+        _condition.notify_all();
+    }
+    waitForThread(false);
+}
+
+//--------------------------------------------------------------
+HashtagExtruderStats HashtagExtruder::get_stats(){
+    return _stats;
+}
+
+//--------------------------------------------------------------
+size_t HashtagExtruder::get_bytes(){
+    size_t bytes = 0;
+    for (int h = 0; h < _alive.size(); h++){
+        bytes += _alive[h].geometry->get_cpu_bytes();
+    }
+    return bytes;
+}
+
+//--------------------------------------------------------------
+// extrudes and quantizes the queued hashtags, one at a time
+//--------------------------------------------------------------
+void HashtagExtruder::threadedFunction(){
+
+    while (isThreadRunning()){
+
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (_jobs.empty() && isThreadRunning()){
+                _condition.wait(lock);
+            }
+            if (!isThreadRunning()) break;
+
+            job = _jobs.front();
+            _jobs.pop_front();
+        }
+
+        vector <ofMesh> meshes = extrude_mesh_from_text(job.text, *_font, _extrusion_depth, _text_scale, false);
+
+        Hashtag hashtag;
+        hashtag.position = job.position;
+        hashtag.width = _font->stringWidth(job.text) * _text_scale;
+        hashtag.birth_time = 0;
+        hashtag.geometry = make_shared<QuantizedGeometry>();
+
+        vector <const ofMesh *> parts;
+        for (int m = 0; m < meshes.size(); m++){
+            strip_to_triangles(meshes[m]);
+            parts.push_back(&meshes[m]);
+        }
+        hashtag.geometry->add_part(parts, -1);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        _ready.push_back(hashtag);
+    }
+}
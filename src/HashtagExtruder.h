@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ofMain.h"
+#include "QuantizedGeometry.h"
+#include "vv_extrude_font.h"
+
+//--------------------------------------------------------------
+// Hashtags extruded in 3D, floating up from the city they were tweeted from.
+// extrude_mesh_from_text() takes way too long for the render thread, so
+// add() only queues the text: a background thread extrudes and quantizes it,
+// and update() uploads the finished ones, only as many bytes per frame as
+// upload_budget allows (always at least one).
+// There's a single worker on purpose: the tessellator behind ofPath is shared.
+//--------------------------------------------------------------
+
+struct HashtagExtruderStats {
+    int pending; // waiting for the worker
+    int ready; // extruded, waiting for the upload
+    int alive; // floating
+    int dropped; // since the start, too many pending
+    size_t uploaded_bytes; // last frame
+};
+
+class HashtagExtruder : public ofThread {
+
+    public:
+
+        void setup(ofTrueTypeFont & font, float text_scale, float extrusion_depth);
+        void add(std::string text, ofPoint position); // from the tweet handler
+        void update(); // main thread
+        void draw(); // inside cam.begin()/end()
+        void stop();
+
+        HashtagExtruderStats get_stats();
+        size_t get_bytes(); // quantized geometry of the floating ones
+
+        size_t upload_budget; // bytes per frame
+        int max_pending;
+        int max_alive;
+        float lifetime; // seconds
+        float rise_speed; // units per second
+
+    private:
+
+        struct Job {
+            std::string text;
+            ofPoint position;
+        };
+
+        struct Hashtag {
+            shared_ptr <QuantizedGeometry> geometry;
+            ofPoint position;
+            float width; // to center the text on the city
+            float birth_time;
+        };
+
+        void threadedFunction();
+
+        ofTrueTypeFont * _font;
+        float _text_scale, _extrusion_depth;
+
+        // main thread only
+        deque <Hashtag> _alive;
+        HashtagExtruderStats _stats;
+
+        // shared with the worker, guarded by ofThread::mutex
+        deque <Job> _jobs;
+        deque <Hashtag> _ready;
+        std::condition_variable _condition;
+};
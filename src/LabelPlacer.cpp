@@ -0,0 +1,240 @@
+#include "LabelPlacer.h"
+
+//--------------------------------------------------------------
+// @args:   cities: the cities created by vv_geojson::create_geojson_map()
+//          font: the font used for the extrusion, used to measure the labels
+//          text_scale: the scale passed to extrude_mesh_from_text()
+//          viewport_w, viewport_h: size of the fbo the map is drawn into
+//--------------------------------------------------------------
+void LabelPlacer::setup(vector<vv_geojson::City> & cities, ofTrueTypeFont & font, float text_scale, float viewport_w, float viewport_h){
+
+    budget = 40;
+    activity_half_life = 120;
+
+    _viewport_w = viewport_w;
+    _viewport_h = viewport_h;
+    _grid_cols = ceil(viewport_w / CELL_SIZE);
+    _grid_rows = ceil(viewport_h / CELL_SIZE);
+    _occupied.assign(_grid_cols * _grid_rows, false);
+
+    int n = cities.size();
+
+    _xs.resize(n);
+    _ys.resize(n);
+    _zs.resize(n);
+    _widths.resize(n);
+    _activity.assign(n, 0);
+    _activity_time.assign(n, 0);
+    _parts.resize(n);
+    _geometry.clear();
+
+    _screen_x.resize(n);
+    _screen_y.resize(n);
+    _screen_w.resize(n);
+    _priorities.resize(n);
+    _order.reserve(n);
+    _placed.reserve(n);
+
+    for (int i = 0; i < n; i++){
+
+        _xs[i] = cities[i].position.x;
+        _ys[i] = cities[i].position.y;
+        _zs[i] = cities[i].position.z;
+        _widths[i] = font.stringWidth(cities[i].name) * text_scale;
+
+        // one quantized part per city instead of one mesh per letter
+        vector <const ofMesh *> letters;
+        for (int m = 0; m < cities[i].meshes.size(); m++){
+            letters.push_back(&cities[i].meshes[m]);
+        }
+        _parts[i] = _geometry.add_part(letters, -1);
+
+        // the quantized copy is all we need from now on
+        vector <ofMesh>().swap(cities[i].meshes);
+    }
+    vv_memory::set(vv_memory::LABEL_MESHES, 0);
+
+    _stats = LabelStats();
+}
+
+//--------------------------------------------------------------
+void LabelPlacer::upload(){
+    _geometry.upload();
+}
+
+//--------------------------------------------------------------
+bool LabelPlacer::upload_slice(size_t max_bytes){
+    return _geometry.upload_slice(max_bytes);
+}
+
+//--------------------------------------------------------------
+void LabelPlacer::set_positions(const vector<ofPoint> & positions){
+
+    if (positions.size() != _xs.size()) return;
+
+    for (int i = 0; i < positions.size(); i++){
+        _xs[i] = positions[i].x;
+        _ys[i] = positions[i].y;
+        _zs[i] = positions[i].z;
+    }
+}
+
+//--------------------------------------------------------------
+void LabelPlacer::notify_activity(int city_index){
+
+    if (city_index < 0 || city_index >= _activity.size()) return;
+
+    // decay what was there, then add the new tweet
+    float now = ofGetElapsedTimef();
+    float decay = pow(0.5f, (now - _activity_time[city_index]) / activity_half_life);
+    _activity[city_index] = _activity[city_index] * decay + 1;
+    _activity_time[city_index] = now;
+}
+
+//--------------------------------------------------------------
+int LabelPlacer::find_nearest_city(ofPoint position, float max_distance){
+
+    int nearest = -1;
+    float nearest_distance = max_distance * max_distance;
+
+    for (int i = 0; i < _xs.size(); i++){
+        float dx = _xs[i] - position.x;
+        float dy = _ys[i] - position.y;
+        float dz = _zs[i] - position.z; // 0 on the flat map, not on the globe
+        float distance = dx * dx + dy * dy + dz * dz;
+        if (distance < nearest_distance){
+            nearest_distance = distance;
+            nearest = i;
+        }
+    }
+    return nearest;
+}
+
+//--------------------------------------------------------------
+// @args:   model_view_projection: the one of the camera, for the map viewport
+//          offset: translation applied to the map before drawing it (see ofApp::draw())
+//--------------------------------------------------------------
+void LabelPlacer::place(const ofMatrix4x4 & model_view_projection, ofPoint offset){
+
+    _offset = offset;
+    _placed.clear();
+    _order.clear();
+    _stats = LabelStats();
+
+    const ofMatrix4x4 & m = model_view_projection;
+    float now = ofGetElapsedTimef();
+    int n = _xs.size();
+
+    // 1. project every candidate (same math of ofCamera::worldToScreen(), done in one go)
+    for (int i = 0; i < n; i++){
+
+        float x = _xs[i] + offset.x;
+        float y = _ys[i] + offset.y;
+        float z = _zs[i] + offset.z;
+
+        float w = m(0,3) * x + m(1,3) * y + m(2,3) * z + m(3,3);
+        float clip_x = m(0,0) * x + m(1,0) * y + m(2,0) * z + m(3,0);
+        float clip_y = m(0,1) * x + m(1,1) * y + m(2,1) * z + m(3,1);
+        // the right end of the label, to know how big it is on screen
+        float w_end = w + m(0,3) * _widths[i];
+        float clip_x_end = clip_x + m(0,0) * _widths[i];
+
+        _stats.tested++;
+
+        // behind the camera
+        if (w <= 0 || w_end <= 0){
+            _screen_w[i] = -1;
+            continue;
+        }
+
+        _screen_x[i] = (clip_x / w + 1.0f) * 0.5f * _viewport_w;
+        _screen_y[i] = (1.0f - clip_y / w) * 0.5f * _viewport_h;
+        _screen_w[i] = fabs((clip_x_end / w_end + 1.0f) * 0.5f * _viewport_w - _screen_x[i]);
+
+        if (_screen_x[i] < 0 || _screen_x[i] > _viewport_w || _screen_y[i] < 0 || _screen_y[i] > _viewport_h){
+            _screen_w[i] = -1;
+            continue;
+        }
+
+        // recent activity first, bigger (closer) labels break the ties
+        float decay = pow(0.5f, (now - _activity_time[i]) / activity_half_life);
+        _priorities[i] = _activity[i] * decay * 1000.0f + _screen_w[i];
+        _order.push_back(i);
+    }
+
+    _stats.rejected_offscreen = n - _order.size();
+
+    std::sort(_order.begin(), _order.end(), [this](int a, int b){
+        return _priorities[a] > _priorities[b];
+    });
+
+    // 2. greedy placement on the occupancy grid
+    std::fill(_occupied.begin(), _occupied.end(), false);
+
+    for (int o = 0; o < _order.size(); o++){
+
+        if (_placed.size() >= budget){
+            _stats.rejected_budget = _order.size() - o;
+            break;
+        }
+
+        int i = _order[o];
+
+        // the extruded text is about as tall as a fifth of its width per letter, keep it simple
+        float label_h = std::max(float(CELL_SIZE), _screen_w[i] * 0.25f);
+        int col_1 = ofClamp(int(_screen_x[i]) / CELL_SIZE, 0, _grid_cols - 1);
+        int col_2 = ofClamp(int(_screen_x[i] + _screen_w[i]) / CELL_SIZE, 0, _grid_cols - 1);
+        int row_1 = ofClamp(int(_screen_y[i] - label_h) / CELL_SIZE, 0, _grid_rows - 1);
+        int row_2 = ofClamp(int(_screen_y[i]) / CELL_SIZE, 0, _grid_rows - 1);
+
+        bool free = true;
+        for (int row = row_1; row <= row_2 && free; row++){
+            for (int col = col_1; col <= col_2; col++){
+                if (_occupied[row * _grid_cols + col]){
+                    free = false;
+                    break;
+                }
+            }
+        }
+
+        if (!free){
+            _stats.rejected_overlap++;
+            continue;
+        }
+
+        for (int row = row_1; row <= row_2; row++){
+            for (int col = col_1; col <= col_2; col++){
+                _occupied[row * _grid_cols + col] = true;
+            }
+        }
+        _placed.push_back(i);
+    }
+
+    _stats.placed = _placed.size();
+}
+
+//--------------------------------------------------------------
+void LabelPlacer::draw(){
+
+    for (int p = 0; p < _placed.size(); p++){
+
+        int i = _placed[p];
+
+        ofPushMatrix();
+        ofTranslate(_xs[i], _ys[i], _zs[i]);
+        ofTranslate(0, 0, -0.1f);
+        ofRotateX(-90);
+        _geometry.draw_part(_parts[i]);
+        ofPopMatrix();
+    }
+}
+
+//--------------------------------------------------------------
+LabelStats LabelPlacer::get_stats(){
+    return _stats;
+}
+
+//--------------------------------------------------------------
+QuantizedGeometry & LabelPlacer::get_geometry(){
+    return _geometry;
+}
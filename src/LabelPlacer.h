@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_geojson.h"
+#include "QuantizedGeometry.h"
+
+//--------------------------------------------------------------
+// Decides which city labels get drawn on the 3d map.
+// Every frame all the cities are projected in one pass using the camera
+// model view projection matrix, sorted by recent tweet activity and placed
+// on a screen space occupancy grid: a label is kept only if all the cells
+// it covers are still free, and only up to a per frame budget.
+// The letters of each city are merged and quantized at setup (see QuantizedGeometry),
+// after that the meshes inside the City structs are released.
+//--------------------------------------------------------------
+
+struct LabelStats {
+    int tested; // candidates projected
+    int placed;
+    int rejected_offscreen; // outside the viewport or behind the camera
+    int rejected_overlap;
+    int rejected_budget;
+};
+
+class LabelPlacer {
+
+    public:
+
+        void setup(vector<vv_geojson::City> & cities, ofTrueTypeFont & font, float text_scale, float viewport_w, float viewport_h);
+        void upload(); // the gl side of setup(), so that setup() can run on a loader thread
+        bool upload_slice(size_t max_bytes); // the same, a few bytes per call (see QuantizedGeometry)
+        void set_positions(const vector<ofPoint> & positions); // one per city, after a reprojection (see GeoStore)
+        void notify_activity(int city_index); // a tweet arrived for this city
+        int find_nearest_city(ofPoint position, float max_distance); // -1 if none
+        void place(const ofMatrix4x4 & model_view_projection, ofPoint offset);
+        void draw(); // inside cam.begin()/end()
+
+        LabelStats get_stats();
+        QuantizedGeometry & get_geometry();
+
+        int budget; // max labels per frame
+        float activity_half_life; // seconds
+
+        static const int CELL_SIZE = 8; // pixels
+
+    private:
+
+        // candidates, as structure of arrays
+        vector <float> _xs, _ys, _zs;
+        vector <float> _widths; // world units, to estimate the label size on screen
+        vector <float> _activity;
+        vector <float> _activity_time; // when _activity was last updated
+        QuantizedGeometry _geometry;
+        vector <int> _parts; // one part of _geometry per city
+
+        // per frame state
+        vector <float> _screen_x, _screen_y, _screen_w;
+        vector <float> _priorities;
+        vector <int> _order;
+        vector <int> _placed;
+        vector <bool> _occupied;
+        int _grid_cols, _grid_rows;
+        float _viewport_w, _viewport_h;
+        ofPoint _offset;
+
+        LabelStats _stats;
+};
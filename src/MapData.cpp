@@ -0,0 +1,129 @@
+#include "MapData.h"
+
+//--------------------------------------------------------------
+MapData::MapData(){
+    load_ms = 0;
+    _upload_stage = 0;
+}
+
+//--------------------------------------------------------------
+// @desc:   parses the geojson, extrudes the names of the cities, tessellates
+//          the countries and quantizes the outlines (no gl calls)
+// @args:   scale: the one given to vv_map_projections::mercator()
+//          viewport_w, viewport_h: size of the fbo the map is drawn into, for the labels
+//          scheduler: for the countries, NULL tessellates them on this thread
+//          outlines: false skips the meshes and the quantization of the outlines,
+//          only the cities, the countries and the labels are kept
+//--------------------------------------------------------------
+bool MapData::load(std::string path, ofTrueTypeFont & font, float scale, float viewport_w, float viewport_h, TaskScheduler * scheduler, bool outlines){
+
+    uint64_t start_time = ofGetElapsedTimeMicros();
+
+    // create the actual geojson meshes and return the centroid
+    // the raw coordinates go in geo_store too, for switching to the globe at runtime
+    vector <ofMesh> poly_meshes;
+    vector <vv_geojson::Country> countries;
+    centroid = vv_geojson::create_geojson_map(path, font, poly_meshes, cities, scale, &geo_store, &countries, outlines);
+    if (outlines ? poly_meshes.empty() : countries.empty() && cities.empty()){
+        ofLogError() << "MapData::load(): nothing to draw in " << path;
+        return false;
+    }
+    vv_memory::set(vv_memory::GEO_STORE, geo_store.get_bytes());
+
+    // the countries are tessellated once, here, and never touched again
+    {
+        vv_trace::Span span("tessellate countries");
+        country_fill.setup(countries, scheduler);
+        vv_memory::set(vv_memory::COUNTRY_FILL, country_fill.get_bytes());
+    }
+
+    // and their grid, for finding them from the coordinates of the tweets
+    {
+        vv_trace::Span span("country locator");
+        country_locator.setup(countries);
+        vv_memory::set(vv_memory::COUNTRY_LOCATOR, country_locator.get_bytes());
+    }
+
+    // store the outlines as 16 bit coordinates, in tiles of 64x64 units
+    if (outlines){
+        vv_trace::Span span("quantize map");
+        geometry.palette.push_back(ofFloatColor(0.0)); // outlines are black
+        geometry.add_tiled(poly_meshes, 64, 0);
+        vector <ofMesh>().swap(poly_meshes);
+        vv_memory::set(vv_memory::MAP_MESHES, 0);
+        vv_memory::set(vv_memory::MAP_GEOMETRY, geometry.get_cpu_bytes());
+    }
+
+    // LABELS
+    // 0.012 is the scale used for the extrusion in create_geojson_map()
+    {
+        vv_trace::Span span("labels setup");
+        labels.setup(cities, font, 0.012, viewport_w, viewport_h);
+        vv_memory::set(vv_memory::LABEL_GEOMETRY, labels.get_geometry().get_cpu_bytes());
+    }
+
+    load_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+    return true;
+}
+
+//--------------------------------------------------------------
+// @args:   projection_t, scale: the projection the map is on right now (see GeoStore::reproject())
+//--------------------------------------------------------------
+void MapData::upload(float projection_t, float scale){
+    while (!upload_slice(projection_t, scale, std::numeric_limits<size_t>::max()));
+}
+
+//--------------------------------------------------------------
+// @desc:   uploads the buffers at most max_bytes per call, so that the
+//          main thread can spread them over a few frames; the map must not
+//          be drawn before it returns true. The projection goes last, so it's
+//          the one of the frame the map is finished in.
+// @args:   projection_t, scale: the projection the map is on right now (see GeoStore::reproject())
+//--------------------------------------------------------------
+bool MapData::upload_slice(float projection_t, float scale, size_t max_bytes){
+
+    switch (_upload_stage){
+
+        case 0:
+            // nothing to upload when the tiles draw the outlines
+            if (geometry.get_num_parts() > 0 && !geometry.upload_slice(max_bytes)) return false;
+            _upload_stage++;
+            return false;
+
+        case 1:
+            if (!labels.upload_slice(max_bytes)) return false;
+            _upload_stage++;
+            return false;
+
+        case 2:
+            if (!country_fill.upload_slice(max_bytes)) return false;
+            vv_memory::set(vv_memory::COUNTRY_FILL, country_fill.get_bytes());
+            _upload_stage++;
+            return false;
+
+        case 3:
+            // a single batch, the same one the projection animation runs every frame
+            geo_store.reproject(projection_t, scale);
+            if (projection_t != 0) labels.set_positions(geo_store.get_point_positions());
+            _upload_stage++;
+            return true;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void MapData::print_stats(){
+
+    cout << "overall centroid: " << centroid << endl;
+    cout << "map geometry parts: " << geometry.get_num_parts() << endl;
+    cout << "cities: " << cities.size() << endl;
+    cout << "countries: " << country_fill.get_num_countries() << ", " << country_fill.get_num_triangles() << " triangles, ";
+    cout << "tessellated in " << country_fill.get_tessellation_ms() << " ms" << endl;
+    cout << "country locator: " << country_locator.get_num_cells() << " cells, " << int(country_locator.get_boundary_ratio() * 100) << "% on borders, ";
+    cout << country_locator.get_bytes() / 1024 << " KB, built in " << country_locator.get_build_ms() << " ms" << endl;
+    cout << "map geometry: " << geometry.get_source_bytes() / 1024 << " KB as ofMesh, ";
+    cout << geometry.get_cpu_bytes() / 1024 << " KB in memory, " << geometry.get_gpu_bytes() / 1024 << " KB on the gpu" << endl;
+    QuantizedGeometry & label_geometry = labels.get_geometry();
+    cout << "label geometry: " << label_geometry.get_source_bytes() / 1024 << " KB as ofMesh, ";
+    cout << label_geometry.get_cpu_bytes() / 1024 << " KB in memory, " << label_geometry.get_gpu_bytes() / 1024 << " KB on the gpu" << endl;
+}
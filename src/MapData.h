@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_geojson.h"
+#include "QuantizedGeometry.h"
+#include "GeoStore.h"
+#include "CountryFill.h"
+#include "CountryLocator.h"
+#include "LabelPlacer.h"
+#include "TaskScheduler.h"
+
+//--------------------------------------------------------------
+// Everything that comes from the geojson file: the outlines as drawn, the
+// raw coordinates for the globe, the countries, the cities and their labels.
+// load() is the slow part and can run on any thread, upload() is the gl one.
+// The app holds it through a shared_ptr, so a new one loaded in the
+// background (see MapReloader) takes the place of the old one with a
+// pointer swap; the gpu buffers of the old one go away with it, so the last
+// reference has to be dropped on the main thread.
+//--------------------------------------------------------------
+
+class MapData {
+
+    public:
+
+        MapData();
+
+        // false if the file couldn't be parsed, or had nothing in it
+        // outlines: false when they're streamed from the tile pyramid (see TileStreamer), geometry stays empty
+        bool load(std::string path, ofTrueTypeFont & font, float scale, float viewport_w, float viewport_h, TaskScheduler * scheduler, bool outlines = true);
+        void upload(float projection_t, float scale); // needs the gl context
+        bool upload_slice(float projection_t, float scale, size_t max_bytes); // the same in steps, true once done
+        void print_stats();
+
+        vector <vv_geojson::City> cities; // the names and positions, the extruded meshes are in labels
+        QuantizedGeometry geometry; // the outlines, as drawn on mercator (empty without outlines)
+        GeoStore geo_store; // unprojected, drawn instead of geometry while not on mercator
+        CountryFill country_fill; // countries filled by their recent tweets
+        CountryLocator country_locator; // the country of a point, same indices as country_fill
+        LabelPlacer labels; // decides which city names are drawn each frame
+        ofPoint centroid; // of the whole shape
+        float load_ms; // load() only
+        std::shared_ptr <vv_memory::Staging> memory; // set while it's built next to the live map, see vv_memory
+
+    private:
+
+        int _upload_stage; // of upload_slice()
+};
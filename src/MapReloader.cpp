@@ -0,0 +1,113 @@
+#include "MapReloader.h"
+
+//--------------------------------------------------------------
+MapReloader::MapReloader(){
+    poll_interval = 1;
+    settle_time = 2;
+    _num_reloads = 0;
+    _last_load_ms = 0;
+}
+
+//--------------------------------------------------------------
+// @args:   path: relative to the data folder, the file the current map was loaded from
+//--------------------------------------------------------------
+void MapReloader::setup(std::string path, std::function<std::shared_ptr<MapData>(std::string path)> load){
+
+    _path = ofToDataPath(path, true);
+    _load = load;
+    _loaded = get_file_state();
+    startThread();
+}
+
+//--------------------------------------------------------------
+std::shared_ptr <MapData> MapReloader::update(){
+
+    std::unique_lock<std::mutex> lock(mutex);
+    std::shared_ptr <MapData> ready = _ready;
+    _ready.reset();
+    return ready;
+}
+
+//--------------------------------------------------------------
+void MapReloader::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopThread();
+        _condition.notify_all();
+    }
+    waitForThread(false);
+}
+
+//--------------------------------------------------------------
+int MapReloader::get_num_reloads(){
+    std::unique_lock<std::mutex> lock(mutex);
+    return _num_reloads;
+}
+
+//--------------------------------------------------------------
+float MapReloader::get_last_load_ms(){
+    std::unique_lock<std::mutex> lock(mutex);
+    return _last_load_ms;
+}
+
+//--------------------------------------------------------------
+bool MapReloader::FileState::operator==(const FileState & other) const {
+    return exists == other.exists && modified == other.modified && size == other.size;
+}
+
+//--------------------------------------------------------------
+MapReloader::FileState MapReloader::get_file_state(){
+
+    FileState state;
+    struct stat info;
+    state.exists = stat(_path.c_str(), &info) == 0;
+    state.modified = state.exists ? info.st_mtime : 0;
+    state.size = state.exists ? info.st_size : 0;
+    return state;
+}
+
+//--------------------------------------------------------------
+void MapReloader::threadedFunction(){
+
+    FileState changed = _loaded; // last state seen, different from _loaded
+    float changed_time = 0;
+
+    while (isThreadRunning()){
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!isThreadRunning()) break;
+            _condition.wait_for(lock, std::chrono::milliseconds(int(poll_interval * 1000)));
+            if (!isThreadRunning()) break;
+        }
+
+        FileState state = get_file_state();
+        if (!state.exists || state == _loaded) continue;
+
+        // still being written, wait until it's quiet
+        if (!(state == changed)){
+            changed = state;
+            changed_time = ofGetElapsedTimef();
+            continue;
+        }
+        if (ofGetElapsedTimef() - changed_time < settle_time) continue;
+
+        cout << "MapReloader: " << _path << " changed, reloading" << endl;
+        uint64_t start_time = ofGetElapsedTimeMicros();
+        std::shared_ptr <MapData> map = _load(_path);
+        float load_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+
+        // the file is not looked at again until it changes, even if it didn't load
+        _loaded = state;
+        if (!map){
+            ofLogWarning() << "MapReloader: couldn't load " << _path << ", keeping the old map";
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        _ready = map; // a newer one replaces one never picked up
+        _num_reloads++;
+        _last_load_ms = load_ms;
+    }
+}
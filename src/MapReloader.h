@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofMain.h"
+#include "MapData.h"
+#include <sys/stat.h>
+
+//--------------------------------------------------------------
+// Watches the geojson file and, when it changes, loads a new MapData on
+// its own thread while the app keeps drawing the old one.
+// The file is loaded only once it stayed the same for settle_time seconds,
+// so a file still being written isn't picked up halfway; if it fails to
+// load, the old map stays.
+// update() hands over the new map; the upload and the swap are left to the
+// main thread, a slice per frame and then between two frames.
+//
+// @example:
+//
+// void ofApp::update(){
+//     std::shared_ptr <MapData> reloaded = reloader.update();
+//     if (reloaded) pending = reloaded;
+//     if (pending && pending->upload_slice(projection_t, scale, 1024 * 1024)){
+//         map = pending;
+//         pending.reset();
+//     }
+// }
+//--------------------------------------------------------------
+
+class MapReloader : public ofThread {
+
+    public:
+
+        MapReloader();
+
+        // load: builds a MapData from the file, on the reloader thread
+        void setup(std::string path, std::function<std::shared_ptr<MapData>(std::string path)> load);
+        std::shared_ptr <MapData> update(); // main thread, NULL until a new map is ready
+        void stop();
+
+        int get_num_reloads();
+        float get_last_load_ms();
+
+        float poll_interval; // seconds
+        float settle_time; // seconds
+
+    private:
+
+        struct FileState {
+            bool exists;
+            time_t modified;
+            off_t size;
+            bool operator==(const FileState & other) const;
+        };
+
+        FileState get_file_state();
+        void threadedFunction();
+
+        std::string _path; // absolute
+        std::function<std::shared_ptr<MapData>(std::string)> _load;
+        std::condition_variable _condition;
+
+        FileState _loaded; // what the current map comes from
+        std::shared_ptr <MapData> _ready;
+        int _num_reloads;
+        float _last_load_ms;
+};
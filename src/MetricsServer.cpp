@@ -0,0 +1,157 @@
+#include "MetricsServer.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+
+// macos has no MSG_NOSIGNAL, SO_NOSIGPIPE does the same there (see answer())
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+//--------------------------------------------------------------
+MetricsServer::MetricsServer(){
+    _port = 0;
+    _file_interval = 10;
+    _socket = -1;
+    _num_requests = 0;
+}
+
+//--------------------------------------------------------------
+// @args:   port: on 127.0.0.1, 0 for no http
+//          file_path: relative to bin/data, written to a temp file and renamed
+//          so a reader never sees half of it; empty for no file
+//          file_interval: seconds between two writes of the file
+//--------------------------------------------------------------
+void MetricsServer::setup(int port, std::string file_path, float file_interval){
+
+    _port = port;
+    _file_path = file_path.empty() ? "" : ofToDataPath(file_path);
+    _file_interval = file_interval;
+
+    if (_port > 0 && !open_socket()){
+        ofLogError() << "MetricsServer: couldn't listen on 127.0.0.1:" << _port << ", metrics are only written to the file";
+    }
+    startThread();
+}
+
+//--------------------------------------------------------------
+void MetricsServer::stop(){
+
+    // the thread wakes up from poll() at least every 200 ms
+    stopThread();
+    waitForThread(false);
+
+    if (_socket >= 0){
+        close(_socket);
+        _socket = -1;
+    }
+}
+
+//--------------------------------------------------------------
+int MetricsServer::get_num_requests(){
+    return _num_requests;
+}
+
+//--------------------------------------------------------------
+bool MetricsServer::open_socket(){
+
+    _socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (_socket < 0) return false;
+
+    // restarting the app shouldn't wait for the old socket to time out
+    int reuse = 1;
+    setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(_socket, (sockaddr *) &address, sizeof(address)) < 0 || listen(_socket, 4) < 0){
+        close(_socket);
+        _socket = -1;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+// @desc:   one request at a time, whatever was asked for: the only thing
+//          there is to get is the metrics
+//--------------------------------------------------------------
+void MetricsServer::answer(int client){
+
+    // a scraper that connects and says nothing doesn't get to block us
+    timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    // a scraper that hangs up early shouldn't kill the app
+    int no_sigpipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+    // the request itself doesn't matter, only that it's over
+    char request[1024];
+    std::string received;
+    while (received.find("\r\n\r\n") == std::string::npos && received.size() < 8192){
+        ssize_t n = recv(client, request, sizeof(request), 0);
+        if (n <= 0) break;
+        received.append(request, n);
+    }
+
+    std::string body = vv_metrics::get_prometheus_text();
+    std::string response = "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + ofToString(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()){
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+    close(client);
+    _num_requests++;
+}
+
+//--------------------------------------------------------------
+void MetricsServer::write_file(){
+
+    std::string temp_path = _file_path + ".tmp";
+    ofstream out(temp_path.c_str());
+    if (!out.is_open()) return;
+    out << vv_metrics::get_prometheus_text();
+    out.close();
+    rename(temp_path.c_str(), _file_path.c_str());
+}
+
+//--------------------------------------------------------------
+void MetricsServer::threadedFunction(){
+
+    float last_file_time = -_file_interval;
+
+    while (isThreadRunning()){
+
+        if (!_file_path.empty() && ofGetElapsedTimef() - last_file_time > _file_interval){
+            write_file();
+            last_file_time = ofGetElapsedTimef();
+        }
+
+        if (_socket < 0){
+            ofSleepMillis(200);
+            continue;
+        }
+
+        pollfd listener = {_socket, POLLIN, 0};
+        if (poll(&listener, 1, 200) <= 0) continue;
+
+        int client = accept(_socket, NULL, NULL);
+        if (client >= 0) answer(client);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_metrics.h"
+
+//--------------------------------------------------------------
+// Serves vv_metrics as prometheus text on http://127.0.0.1:port/metrics,
+// and/or writes it to a file every few seconds (for node_exporter's textfile
+// collector, or for a plain cron job), from its own thread.
+// Only localhost can connect: the fleet is scraped through ssh or a local
+// agent, the installation never listens on the network.
+//
+// @example:
+//
+// metrics_server.setup(9145, "metrics.prom");
+// ...
+// metrics_server.stop();
+//--------------------------------------------------------------
+
+class MetricsServer : public ofThread {
+
+    public:
+
+        MetricsServer();
+
+        void setup(int port, std::string file_path = "", float file_interval = 10); // port 0: no http, empty path: no file
+        void stop();
+
+        int get_num_requests();
+
+    private:
+
+        void threadedFunction();
+        bool open_socket();
+        void answer(int client);
+        void write_file();
+
+        int _port;
+        std::string _file_path;
+        float _file_interval;
+        int _socket;
+        std::atomic<int> _num_requests;
+};
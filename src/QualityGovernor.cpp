@@ -0,0 +1,157 @@
+#include "QualityGovernor.h"
+
+//--------------------------------------------------------------
+// the default levels drop what costs the most and shows the least first:
+// the multisampling of the map, then the fireworks, then the artwork
+//--------------------------------------------------------------
+QualityGovernor::QualityGovernor(){
+
+    //         grains particles fireworks lod labels msaa
+    QualityLevel best =     {8, 30, 16, 0, 40, 8};
+    QualityLevel level_1 =  {8, 24, 12, 0, 30, 4};
+    QualityLevel level_2 =  {6, 20, 10, 1, 24, 4};
+    QualityLevel level_3 =  {5, 16,  8, 1, 16, 2};
+    QualityLevel level_4 =  {4, 12,  6, 2, 12, 0};
+    QualityLevel cheapest = {3,  8,  4, 2,  8, 0};
+    levels = {best, level_1, level_2, level_3, level_4, cheapest};
+
+    window = 1;
+    warm_up = 1;
+    down_work = 0.85f;
+    up_work = 0.55f;
+    up_hold = 10;
+    cooldown = 3;
+
+    _budget_ms = 1000 / 45.0f;
+    _level = 0;
+    _warm_up_ms = warm_up * 1000;
+    _window_ms = _frame_sum = _work_sum = 0;
+    _num_frames = 0;
+    _last_frame_ms = _last_work_ms = 0;
+    _under_ms = 0;
+    _cooldown_ms = 0;
+    _since_change_ms = 0;
+    _up_hold_scale = 1;
+    _last_change_up = false;
+}
+
+//--------------------------------------------------------------
+// @args:   target_fps: the frame budget is 1000 / target_fps ms
+//          log_path: every decision is appended to it, empty for the console only
+//--------------------------------------------------------------
+void QualityGovernor::setup(float target_fps, std::string log_path){
+
+    _budget_ms = 1000 / target_fps;
+    _level = 0;
+    _warm_up_ms = warm_up * 1000;
+    _log_path = log_path.empty() ? "" : ofToDataPath(log_path);
+
+    if (!_log_path.empty() && !ofFile::doesFileExist(_log_path)){
+        ofstream out(_log_path.c_str());
+        out << "time,from,to,frame_ms,work_ms,budget_ms,reason,";
+        out << "grains_per_step,particles_per_explosion,max_fireworks,map_lod_bias,label_budget,msaa_samples" << endl;
+    }
+}
+
+//--------------------------------------------------------------
+// @args:   frame_ms: since the previous frame, vsync and frame rate limit included
+//          work_ms: from the start of update() to the end of draw()
+// @return: true if the level changed, get_settings() has the new one
+//--------------------------------------------------------------
+bool QualityGovernor::update(float frame_ms, float work_ms){
+
+    // the frames right after loading, nothing to learn from them
+    if (_warm_up_ms > 0){
+        _warm_up_ms -= frame_ms;
+        return false;
+    }
+
+    _window_ms += frame_ms;
+    _frame_sum += frame_ms;
+    _work_sum += work_ms;
+    _num_frames++;
+    _cooldown_ms = std::max(0.0f, _cooldown_ms - frame_ms);
+    _since_change_ms += frame_ms;
+
+    if (_window_ms < window * 1000) return false;
+
+    float window_ms = _window_ms;
+    _last_frame_ms = _frame_sum / _num_frames;
+    _last_work_ms = _work_sum / _num_frames;
+    _window_ms = _frame_sum = _work_sum = 0;
+    _num_frames = 0;
+
+    // a minute without changes, the flapping is forgotten
+    if (_since_change_ms > 60000) _up_hold_scale = 1;
+
+    // missing the frame rate, or about to
+    bool missing = _last_frame_ms > _budget_ms * 1.1f;
+    bool slow = missing || _last_work_ms > _budget_ms * down_work;
+    bool fast = !missing && _last_work_ms < _budget_ms * up_work;
+
+    std::string numbers = "frames " + ofToString(_last_frame_ms, 1) + " ms, work " + ofToString(_last_work_ms, 1) + " ms";
+
+    if (slow){
+        _under_ms = 0;
+        if (_cooldown_ms > 0 || _level == levels.size() - 1) return false;
+
+        // raised too early: it'll wait longer next time
+        if (_last_change_up && _since_change_ms < up_hold * 1000 * _up_hold_scale){
+            _up_hold_scale = std::min(8.0f, _up_hold_scale * 2);
+        }
+        change_level(_level + 1, (missing ? "missing the frame rate, " : "little room left, ") + numbers);
+        return true;
+    }
+
+    if (!fast){
+        _under_ms = 0;
+        return false;
+    }
+
+    _under_ms += window_ms;
+    if (_level == 0 || _cooldown_ms > 0 || _under_ms < up_hold * 1000 * _up_hold_scale) return false;
+
+    change_level(_level - 1, "room for " + ofToString(_under_ms / 1000, 0) + " s, " + numbers);
+    return true;
+}
+
+//--------------------------------------------------------------
+int QualityGovernor::get_level(){
+    return _level;
+}
+
+//--------------------------------------------------------------
+const QualityLevel & QualityGovernor::get_settings(){
+    return levels[_level];
+}
+
+//--------------------------------------------------------------
+std::string QualityGovernor::get_status(){
+    return "quality: " + ofToString(_level) + " of " + ofToString(levels.size() - 1) +
+        ", frames " + ofToString(_last_frame_ms, 1) + " ms, work " + ofToString(_last_work_ms, 1) +
+        " of " + ofToString(_budget_ms, 1) + " ms";
+}
+
+//--------------------------------------------------------------
+void QualityGovernor::change_level(int level, std::string reason){
+
+    const QualityLevel & q = levels[level];
+    cout << "QualityGovernor: level " << _level << " -> " << level << " (" << reason << "): ";
+    cout << q.grains_per_step << " grains per step, " << q.particles_per_explosion << " particles per explosion, ";
+    cout << q.max_fireworks << " fireworks, map lod +" << q.map_lod_bias << ", " << q.label_budget << " labels, ";
+    cout << q.msaa_samples << "x msaa" << endl;
+
+    if (!_log_path.empty()){
+        ofstream out(_log_path.c_str(), std::ios::app);
+        out << ofGetTimestampString("%Y-%m-%d %H:%M:%S") << "," << _level << "," << level << ",";
+        out << _last_frame_ms << "," << _last_work_ms << "," << _budget_ms << ",\"" << reason << "\",";
+        out << q.grains_per_step << "," << q.particles_per_explosion << "," << q.max_fireworks << ",";
+        out << q.map_lod_bias << "," << q.label_budget << "," << q.msaa_samples << endl;
+    }
+
+    _last_change_up = level < _level;
+    _level = level;
+    _cooldown_ms = cooldown * 1000;
+    _since_change_ms = 0;
+    _under_ms = 0;
+}
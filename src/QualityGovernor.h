@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+
+//--------------------------------------------------------------
+// Holds the frame rate by trading quality for time when the frames get
+// too slow, and taking it back once there's room again.
+// Every frame gets the time between two frames (what the visitor sees) and
+// the time the app actually worked (without waiting for vsync, what tells
+// how much room there is). They're averaged over a window: a slow window
+// drops a level right away, the level comes back only after a long run of
+// fast windows, and nothing changes for a while after a change, so the
+// new level gets measured before the next decision. A level that was
+// dropped again right after coming back takes twice as long to come back
+// the next time. The first warm_up seconds aren't measured at all: right
+// after loading the frames still pay for uploads and cold caches.
+// Every change is logged with the numbers that caused it.
+//
+// @example:
+//
+// governor.setup(45, "quality_log.csv");
+// if (governor.update(ofGetLastFrameTime() * 1000, work_ms)){
+//     const QualityLevel & quality = governor.get_settings();
+//     sand_line.grains_per_step = quality.grains_per_step;
+// }
+//--------------------------------------------------------------
+
+struct QualityLevel {
+    int grains_per_step; // SandLine, per step of a stroke
+    int particles_per_explosion; // Firework
+    int max_fireworks;
+    int map_lod_bias; // TileStreamer, zoom levels coarser
+    int label_budget; // LabelPlacer, labels per frame
+    int msaa_samples; // of the map fbo, 0 for none
+};
+
+class QualityGovernor {
+
+    public:
+
+        QualityGovernor();
+
+        void setup(float target_fps, std::string log_path = ""); // log_path: a csv of the decisions, relative to bin/data
+        bool update(float frame_ms, float work_ms); // every frame, true when the level changed
+
+        int get_level(); // 0 is the best one
+        const QualityLevel & get_settings();
+        std::string get_status(); // one line, for the hud
+
+        vector <QualityLevel> levels; // from the best to the cheapest, can be changed before setup()
+        float window; // seconds averaged for each decision
+        float warm_up; // seconds ignored after the first update()
+        float down_work, up_work; // of the frame budget: average work above down_work drops a level, below up_work can raise it
+        float up_hold; // seconds of fast windows before raising a level
+        float cooldown; // seconds without decisions after a change
+
+    private:
+
+        void change_level(int level, std::string reason);
+
+        float _budget_ms;
+        int _level;
+        std::string _log_path;
+
+        float _warm_up_ms; // left before the first window
+
+        // the current window
+        float _window_ms, _frame_sum, _work_sum;
+        int _num_frames;
+        float _last_frame_ms, _last_work_ms; // averages of the last window
+
+        float _under_ms; // fast windows in a row
+        float _cooldown_ms;
+        float _since_change_ms; // since the last change
+        float _up_hold_scale; // doubled when a level has to be dropped right after being raised
+        bool _last_change_up;
+};
@@ -0,0 +1,248 @@
+#include "QuantizedGeometry.h"
+#include <float.h>
+
+//--------------------------------------------------------------
+QuantizedGeometry::QuantizedGeometry(){
+    _vertex_buffer = 0;
+    _index_buffer = 0;
+    _uploaded_bytes = 0;
+    _source_bytes = 0;
+}
+
+//--------------------------------------------------------------
+QuantizedGeometry::~QuantizedGeometry(){
+    clear();
+}
+
+//--------------------------------------------------------------
+// @desc:   quantizes the given meshes around the center of their bounding box.
+//          OF_PRIMITIVE_LINE_STRIP meshes are drawn as they are, any other mode
+//          is drawn through its indices (it must have less than 65536 vertices).
+//          All the meshes of a part must use the same mode.
+// @return: the id of the part, to be used with draw_part()
+//--------------------------------------------------------------
+int QuantizedGeometry::add_part(const vector<const ofMesh *> & meshes, int palette_index){
+
+    Part part;
+    part.palette_index = palette_index;
+    part.mode = GL_LINE_STRIP;
+    part.num_indices = 0;
+    part.index_offset = _indices.size();
+
+    // bounding box, and whether the part is flat
+    ofVec3f min_p(FLT_MAX, FLT_MAX, FLT_MAX);
+    ofVec3f max_p(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (int m = 0; m < meshes.size(); m++){
+        const vector <ofVec3f> & vertices = meshes[m]->getVertices();
+        for (int v = 0; v < vertices.size(); v++){
+            min_p.x = std::min(min_p.x, vertices[v].x); max_p.x = std::max(max_p.x, vertices[v].x);
+            min_p.y = std::min(min_p.y, vertices[v].y); max_p.y = std::max(max_p.y, vertices[v].y);
+            min_p.z = std::min(min_p.z, vertices[v].z); max_p.z = std::max(max_p.z, vertices[v].z);
+        }
+        if (meshes[m]->getMode() != OF_PRIMITIVE_LINE_STRIP) part.mode = GL_TRIANGLES;
+
+        _source_bytes += meshes[m]->getNumVertices() * sizeof(ofVec3f);
+        _source_bytes += meshes[m]->getNumColors() * sizeof(ofFloatColor);
+        _source_bytes += meshes[m]->getNumIndices() * sizeof(ofIndexType);
+    }
+    if (min_p.x > max_p.x) min_p = max_p = ofVec3f(0, 0, 0); // no vertices at all
+
+    // flat parts (like the map, where z is always 0) don't store z at all
+    part.components = min_p.z == max_p.z ? 2 : 3;
+    part.origin = (min_p + max_p) * 0.5f;
+    float half_extent = std::max(max_p.x - min_p.x, std::max(max_p.y - min_p.y, max_p.z - min_p.z)) * 0.5f;
+    part.step = half_extent > 0 ? half_extent / 32767.0f : 1.0f;
+
+    // keep every part 4 bytes aligned inside the buffer
+    if (_vertices.size() % 2 != 0) _vertices.push_back(0);
+    part.vertex_offset = _vertices.size() * sizeof(int16_t);
+
+    int first_vertex = 0;
+    for (int m = 0; m < meshes.size(); m++){
+
+        const vector <ofVec3f> & vertices = meshes[m]->getVertices();
+        for (int v = 0; v < vertices.size(); v++){
+            ofVec3f q = (vertices[v] - part.origin) / part.step;
+            _vertices.push_back(int16_t(ofClamp(round(q.x), -32767, 32767)));
+            _vertices.push_back(int16_t(ofClamp(round(q.y), -32767, 32767)));
+            if (part.components == 3) _vertices.push_back(int16_t(ofClamp(round(q.z), -32767, 32767)));
+        }
+
+        if (part.mode == GL_LINE_STRIP){
+            part.firsts.push_back(first_vertex);
+            part.counts.push_back(vertices.size());
+        }
+        else {
+            // ofPath tessellations come with indices, plain meshes don't
+            const vector <ofIndexType> & indices = meshes[m]->getIndices();
+            if (indices.empty()){
+                for (int v = 0; v < vertices.size(); v++) _indices.push_back(first_vertex + v);
+            }
+            else {
+                for (int i = 0; i < indices.size(); i++) _indices.push_back(first_vertex + indices[i]);
+            }
+        }
+        first_vertex += vertices.size();
+    }
+
+    if (first_vertex > 65535 && part.mode != GL_LINE_STRIP){
+        ofLogWarning("QuantizedGeometry") << "part with " << first_vertex << " vertices, indices will overflow";
+    }
+
+    part.num_indices = _indices.size() - part.index_offset;
+    _parts.push_back(part);
+
+    return _parts.size() - 1;
+}
+
+//--------------------------------------------------------------
+// @desc:   groups the given line strips in square tiles (by the first vertex of each strip)
+//          so that the whole map is drawn with a handful of draw calls
+// @return: the ids of the parts created
+//--------------------------------------------------------------
+vector <int> QuantizedGeometry::add_tiled(const vector<ofMesh> & meshes, float tile_size, int palette_index){
+
+    std::map <std::pair<int, int>, vector<const ofMesh *> > tiles;
+
+    for (int m = 0; m < meshes.size(); m++){
+        if (meshes[m].getNumVertices() == 0) continue;
+        ofVec3f p = meshes[m].getVertex(0);
+        std::pair<int, int> tile(floor(p.x / tile_size), floor(p.y / tile_size));
+        tiles[tile].push_back(&meshes[m]);
+    }
+
+    vector <int> parts;
+    for (std::map <std::pair<int, int>, vector<const ofMesh *> >::iterator it = tiles.begin(); it != tiles.end(); ++it){
+        parts.push_back(add_part(it->second, palette_index));
+    }
+    return parts;
+}
+
+//--------------------------------------------------------------
+void QuantizedGeometry::upload(){
+    _uploaded_bytes = 0;
+    upload_slice(std::numeric_limits<size_t>::max());
+}
+
+//--------------------------------------------------------------
+// @desc:   the first slice allocates the buffers, every slice after that
+//          copies the next max_bytes into them; nothing should be drawn
+//          until the last one
+// @return: true once everything is on the gpu
+//--------------------------------------------------------------
+bool QuantizedGeometry::upload_slice(size_t max_bytes){
+
+    GLenum targets[2] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER};
+    GLuint * buffers[2] = {&_vertex_buffer, &_index_buffer};
+    const char * data[2] = {(const char *) _vertices.data(), (const char *) _indices.data()};
+    size_t sizes[2] = {_vertices.size() * sizeof(int16_t), _indices.size() * sizeof(uint16_t)};
+
+    if (_uploaded_bytes == 0){
+        for (int b = 0; b < 2; b++){
+            if (*buffers[b] == 0) glGenBuffers(1, buffers[b]);
+            glBindBuffer(targets[b], *buffers[b]);
+            glBufferData(targets[b], sizes[b], NULL, GL_STATIC_DRAW);
+            glBindBuffer(targets[b], 0);
+        }
+    }
+
+    size_t start = 0; // of this buffer, as if they were a single array
+    for (int b = 0; b < 2; b++){
+        if (max_bytes > 0 && _uploaded_bytes < start + sizes[b]){
+            size_t from = _uploaded_bytes - start;
+            size_t bytes = std::min(sizes[b] - from, max_bytes);
+            glBindBuffer(targets[b], *buffers[b]);
+            glBufferSubData(targets[b], from, bytes, data[b] + from);
+            glBindBuffer(targets[b], 0);
+            _uploaded_bytes += bytes;
+            max_bytes -= bytes;
+        }
+        start += sizes[b];
+    }
+
+    return _uploaded_bytes >= start;
+}
+
+//--------------------------------------------------------------
+void QuantizedGeometry::draw_part(int part_id){
+
+    if (part_id < 0 || part_id >= _parts.size() || _vertex_buffer == 0) return;
+
+    Part & part = _parts[part_id];
+
+    ofPushStyle();
+    if (part.palette_index >= 0 && part.palette_index < palette.size()){
+        ofSetColor(palette[part.palette_index]);
+    }
+
+    // dequantize: vertex = origin + quantized * step
+    ofPushMatrix();
+    ofTranslate(part.origin);
+    ofScale(part.step, part.step, part.step);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(part.components, GL_SHORT, 0, (const GLvoid *) part.vertex_offset);
+
+    if (part.mode == GL_LINE_STRIP){
+        glMultiDrawArrays(GL_LINE_STRIP, &part.firsts[0], &part.counts[0], part.firsts.size());
+    }
+    else if (part.num_indices > 0){
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+        glDrawElements(part.mode, part.num_indices, GL_UNSIGNED_SHORT, (const GLvoid *) (part.index_offset * sizeof(uint16_t)));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    ofPopMatrix();
+    ofPopStyle();
+}
+
+//--------------------------------------------------------------
+void QuantizedGeometry::draw_all(){
+    for (int p = 0; p < _parts.size(); p++){
+        draw_part(p);
+    }
+}
+
+//--------------------------------------------------------------
+void QuantizedGeometry::clear(){
+
+    if (_vertex_buffer != 0) glDeleteBuffers(1, &_vertex_buffer);
+    if (_index_buffer != 0) glDeleteBuffers(1, &_index_buffer);
+    _vertex_buffer = 0;
+    _index_buffer = 0;
+    _uploaded_bytes = 0;
+
+    _parts.clear();
+    _vertices.clear();
+    _indices.clear();
+    _source_bytes = 0;
+}
+
+//--------------------------------------------------------------
+int QuantizedGeometry::get_num_parts(){
+    return _parts.size();
+}
+
+//--------------------------------------------------------------
+size_t QuantizedGeometry::get_cpu_bytes(){
+
+    size_t bytes = _vertices.capacity() * sizeof(int16_t) + _indices.capacity() * sizeof(uint16_t);
+    for (int p = 0; p < _parts.size(); p++){
+        bytes += sizeof(Part) + _parts[p].firsts.capacity() * sizeof(GLint) + _parts[p].counts.capacity() * sizeof(GLsizei);
+    }
+    return bytes;
+}
+
+//--------------------------------------------------------------
+size_t QuantizedGeometry::get_gpu_bytes(){
+    return _vertices.size() * sizeof(int16_t) + _indices.size() * sizeof(uint16_t);
+}
+
+//--------------------------------------------------------------
+size_t QuantizedGeometry::get_source_bytes(){
+    return _source_bytes;
+}
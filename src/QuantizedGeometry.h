@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ofMain.h"
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// Compact storage for static geometry (map outlines and city labels).
+// Meshes are added in parts: every part has its own origin and step, and its
+// vertices are stored as 16 bit integers relative to that origin (2 components
+// when the part is flat, 3 otherwise). There are no per vertex colors: each
+// part points to an entry of a shared palette.
+// The same quantized arrays are uploaded as they are to the gpu and the
+// dequantization happens at draw time through the modelview matrix
+// (translate to the origin, scale by the step), so this relies on the default
+// fixed function renderer (see main.cpp).
+//--------------------------------------------------------------
+
+class QuantizedGeometry {
+
+    public:
+
+        QuantizedGeometry();
+        ~QuantizedGeometry();
+
+        // owns the gl buffers, a copy would delete them twice
+        QuantizedGeometry(const QuantizedGeometry &) = delete;
+        QuantizedGeometry & operator=(const QuantizedGeometry &) = delete;
+
+        // all meshes of a part share the same origin and step,
+        // a palette_index of -1 draws the part with the current color
+        int add_part(const vector<const ofMesh *> & meshes, int palette_index);
+        // groups line strips in square tiles, one part per tile
+        vector <int> add_tiled(const vector<ofMesh> & meshes, float tile_size, int palette_index);
+
+        void upload(); // needs the gl context, call it from setup()
+        bool upload_slice(size_t max_bytes); // the same a few bytes at a time, true once all is uploaded
+        void draw_part(int part);
+        void draw_all();
+        void clear();
+
+        int get_num_parts();
+        size_t get_cpu_bytes(); // quantized arrays kept in memory
+        size_t get_gpu_bytes(); // quantized arrays uploaded to the gpu
+        size_t get_source_bytes(); // what the same meshes took as ofMesh-es
+
+        vector <ofFloatColor> palette;
+
+    private:
+
+        struct Part {
+            ofVec3f origin;
+            float step;
+            int components; // 2 or 3
+            size_t vertex_offset; // in bytes, inside the vertex buffer
+            size_t index_offset; // in indices, inside the index buffer
+            int num_indices; // 0 for line strips
+            vector <GLint> firsts; // one range per line strip
+            vector <GLsizei> counts;
+            GLenum mode;
+            int palette_index;
+        };
+
+        vector <Part> _parts;
+        vector <int16_t> _vertices;
+        vector <uint16_t> _indices;
+        GLuint _vertex_buffer, _index_buffer;
+        size_t _uploaded_bytes; // the vertices first, then the indices
+        size_t _source_bytes;
+};
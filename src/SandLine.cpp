@@ -8,13 +8,18 @@ void SandLine::setup(float w, float h, float max_size, float max_alpha){
     _max_size = max_size;
     _max_alpha = max_alpha;
     current_mode = BEZIER_MODE;
+    grains_per_step = 8;
 
     _enable_draw = false;
 
     // used in attractor mode
-    acceleration = ofVec2f(0.0f, 0.0f);
-    velocity = ofVec2f(0.0f, 0.0f);
-    position = ofVec2f(0.0f, 0.0f);
+    swarm.setup(8192, 6, max_alpha);
+
+    // dirty tiles
+    _tiles_cols = (int(w) + TILE_SIZE - 1) / TILE_SIZE;
+    _tiles_rows = (int(h) + TILE_SIZE - 1) / TILE_SIZE;
+    _dirty_tiles.assign(_tiles_cols * _tiles_rows, false);
+    _has_pending = false;
     
     // initial cleaning of the fbo
     fbo.begin();
@@ -28,68 +33,47 @@ void SandLine::setup(float w, float h, float max_size, float max_alpha){
 //--------------------------------------------------------------
 void SandLine::update(){
 
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    vv_metrics::set(vv_metrics::SAND_GRAINS, sand_grains.size());
+
     fbo.begin();
 
     // creates a series of bezier with random handles 
     // passing through the given points (see add_point())
-    if (current_mode == BEZIER_MODE){
-        // only draw after we added a point
-        if (_enable_draw){
-            ofPushStyle();
-            for (int i = 0; i < sand_grains.size(); i++){
-                ofSetColor(sand_grains.at(i).col);
-                ofDrawCircle(sand_grains.at(i).pos.x, sand_grains.at(i).pos.y, sand_grains.at(i).size);
-            }
-            ofPopStyle();
+    // only draw after we added a point
+    if (_enable_draw){
+        ofPushStyle();
+        for (int i = 0; i < sand_grains.size(); i++){
+            ofSetColor(sand_grains.at(i).col);
+            ofDrawCircle(sand_grains.at(i).pos.x, sand_grains.at(i).pos.y, sand_grains.at(i).size);
+        }
+        ofPopStyle();
+
+        // only now the stroke is in the fbo, the autosave can have its tiles
+        if (_has_pending){
+            mark_dirty(_pending_x1, _pending_y1, _pending_x2, _pending_y2);
+            _has_pending = false;
         }
     }
-    // feel the attraction toward the latest target set
-    // leaves a trail of dots in this eternal search
-    else if (current_mode == ATTRACTOR_MODE){
 
-        ofPushStyle();
+    // feel the attraction toward the targets set by the tweets
+    // every walker leaves a trail of dots in this eternal search (see WalkerSwarm)
+    if (swarm.size() > 0){
 
-        ofVec2f attraction_force = latest_target - position;
-        // this.acc = p5.Vector.sub(target, this.pos);
-        attraction_force.normalize();
-        attraction_force += ofVec2f(ofRandom(-0.75f, 0.75f), ofRandom(-0.75f, 0.75f));
-        
-        float distance = ofDist(latest_target.x, latest_target.y, position.x, position.y);
-        distance = ofClamp(distance, 1, 32); // avoids crazy spinning
-
-        float mass = 0.5f;
-        // float attraction_factor = ofMap(distance, 0, dist(fbo.getWidth()/2, fbo.getHeight()/2, fbo.getWidth(), fbo.getHeight())), 0, 0.4);
-        attraction_force *= mass / distance * distance;
-        acceleration += attraction_force;
-        velocity += acceleration;
-        velocity.limit(8.0);
-        position += velocity;
-
-        // those trail of points have a gaussian distribution around the current position
         // the standard deviation (basically the spread of the "brush") follows a 1d noise over time
-        float center_value = 0;
         float stdev = ofMap(ofNoise(ofGetElapsedTimef() * 0.8), 0, 1, 0.000035, 0.12);
         int max_offset = 32;
 
-        for (int i = 0; i < 32; i++){
-
-            float size = ofRandom(_max_size);
-            float alpha = ofRandom(_max_alpha);
-            
-            std::normal_distribution<double> gaussian_distribution(center_value, stdev);
-            
-            ofVec2f offset = position;
-            offset.x += gaussian_distribution(generator) * max_offset;
-            offset.y += gaussian_distribution(generator) * max_offset;
+        swarm.update(stdev);
+        swarm.draw();
 
-            ofSetColor(0, alpha);
-            ofDrawCircle(offset.x, offset.y, size, size);
+        // the gaussian spread is tiny, max_offset is a safe bound for the brush
+        const float * xs = swarm.get_xs();
+        const float * ys = swarm.get_ys();
+        for (int i = 0; i < swarm.size(); i++){
+            mark_dirty(xs[i] - max_offset, ys[i] - max_offset, xs[i] + max_offset, ys[i] + max_offset);
         }
-
-        // reset everything
-        acceleration = ofVec2f(0, 0);
-
-        ofPopStyle();
     }
 
     fbo.end();
@@ -100,6 +84,8 @@ void SandLine::update(){
 //--------------------------------------------------------------
 void SandLine::add_point(ofVec3f p, int max_offset, int max_radius){
 
+    std::unique_lock<std::mutex> lock(_mutex);
+
     _enable_draw = true;
 
     // we need at least one point before drawing a line!
@@ -132,11 +118,21 @@ void SandLine::add_point(ofVec3f p, int max_offset, int max_radius){
         // when we switch to attractor mode the latest target
         // should be following the latest added point
         latest_target = end_p;
-        position = start_p;
 
         // remove the first element, we don't need it anymore
         main_sand_points.pop_front();
 
+        // in attractor mode a new walker starts from the previous point
+        // and chases the new one, no bezier needed
+        if (current_mode == ATTRACTOR_MODE){
+            swarm.spawn(start_p, end_p);
+            return;
+        }
+
+        // the main thread can draw meanwhile, the grains go in once they're all there
+        lock.unlock();
+        deque <Grain, vv_memory::CountingAllocator<Grain, vv_memory::SAND_GRAINS> > grains;
+
         // create the bezier curve
         ofPolyline bezier;
         bezier.addVertex(start_p);
@@ -148,8 +144,13 @@ void SandLine::add_point(ofVec3f p, int max_offset, int max_radius){
         float center_value = 0;
         float stdev = ofRandom(0.035, 0.115);
 
+        // bounding box of the stroke, used to mark the dirty tiles
+        float min_x = start_p.x, min_y = start_p.y;
+        float max_x = start_p.x, max_y = start_p.y;
+
+        int num_grains = grains_per_step; // read once, the governor may change it meanwhile
         for (float f = 0; f < 1.0f; f+=0.005){
-            for (int i = 0; i < 8; i++){
+            for (int i = 0; i < num_grains; i++){
 
                 std::normal_distribution<double> gaussian_distribution(center_value, stdev);
 
@@ -161,12 +162,72 @@ void SandLine::add_point(ofVec3f p, int max_offset, int max_radius){
                 grain.pos = mid_point;
                 grain.col = ofColor(255, ofRandom(_max_alpha));
                 grain.size = ofRandom(_max_size);
-                sand_grains.push_back(grain);
+                grains.push_back(grain);
+
+                min_x = std::min(min_x, mid_point.x);
+                min_y = std::min(min_y, mid_point.y);
+                max_x = std::max(max_x, mid_point.x);
+                max_y = std::max(max_y, mid_point.y);
             }
         }
+
+        lock.lock();
+        sand_grains.swap(grains);
+        _enable_draw = true;
+
+        // marked dirty by update() once drawn, a checkpoint before that would miss it
+        min_x -= _max_size;
+        min_y -= _max_size;
+        max_x += _max_size;
+        max_y += _max_size;
+        if (_has_pending){
+            min_x = std::min(min_x, _pending_x1);
+            min_y = std::min(min_y, _pending_y1);
+            max_x = std::max(max_x, _pending_x2);
+            max_y = std::max(max_y, _pending_y2);
+        }
+        _pending_x1 = min_x;
+        _pending_y1 = min_y;
+        _pending_x2 = max_x;
+        _pending_y2 = max_y;
+        _has_pending = true;
     }
 }
 
+//--------------------------------------------------------------
+// marks as dirty all the tiles overlapping the given rectangle (in canvas pixels)
+//--------------------------------------------------------------
+void SandLine::mark_dirty(float x1, float y1, float x2, float y2){
+
+    int col_1 = ofClamp(int(floor(x1)) / TILE_SIZE, 0, _tiles_cols - 1);
+    int col_2 = ofClamp(int(floor(x2)) / TILE_SIZE, 0, _tiles_cols - 1);
+    int row_1 = ofClamp(int(floor(y1)) / TILE_SIZE, 0, _tiles_rows - 1);
+    int row_2 = ofClamp(int(floor(y2)) / TILE_SIZE, 0, _tiles_rows - 1);
+
+    for (int row = row_1; row <= row_2; row++){
+        for (int col = col_1; col <= col_2; col++){
+            _dirty_tiles[row * _tiles_cols + col] = true;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+// returns the indices (row * cols + col) of the tiles changed since the last call
+// and starts tracking again from a clean state
+//--------------------------------------------------------------
+vector <int> SandLine::take_dirty_tiles(){
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    vector <int> tiles;
+    for (int i = 0; i < _dirty_tiles.size(); i++){
+        if (_dirty_tiles[i]){
+            tiles.push_back(i);
+            _dirty_tiles[i] = false;
+        }
+    }
+    return tiles;
+}
+
 //--------------------------------------------------------------
 ofFbo * SandLine::get_fbo_pointer(){
     return &fbo;
@@ -174,31 +235,39 @@ ofFbo * SandLine::get_fbo_pointer(){
 
 //--------------------------------------------------------------
 void SandLine::enable_draw(bool val){
+    std::unique_lock<std::mutex> lock(_mutex);
     _enable_draw = val;
 }
 
 //--------------------------------------------------------------
 void SandLine::set_target(ofVec2f target){
+    std::unique_lock<std::mutex> lock(_mutex);
     latest_target = target;
 }
 
 //--------------------------------------------------------------
 void SandLine::set_mode(int mode){
     // cout << "SandLine::set_mode: " << mode << endl;
+    std::unique_lock<std::mutex> lock(_mutex);
     current_mode = mode;
 }
 
 //--------------------------------------------------------------
 void SandLine::reset(){
 
+    std::unique_lock<std::mutex> lock(_mutex);
     current_mode = BEZIER_MODE;
 
     _enable_draw = false;
 
     // used in attractor mode
-    acceleration = ofVec2f(0.0f, 0.0f);
-    velocity = ofVec2f(0.0f, 0.0f);
-    position = ofVec2f(0.0f, 0.0f);
+    swarm.clear();
+    sand_grains.clear();
+    main_sand_points.clear();
+
+    // a new artwork starts from a clean canvas, nothing to checkpoint yet
+    _dirty_tiles.assign(_dirty_tiles.size(), false);
+    _has_pending = false;
     
     // initial cleaning of the fbo
     fbo.begin();
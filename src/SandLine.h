@@ -1,9 +1,15 @@
 #include "ofMain.h"
+#include "WalkerSwarm.h"
+#include "vv_memory.h"
+#include "vv_metrics.h"
 #include <random>
+#include <atomic>
 
 //--------------------------------------------------------------
 // Inspired by Inconvergent's Sand Spline, even if his is way more awesome
 // (http://inconvergent.net/generative/sand-spline/)
+// add_point() comes from the simulation thread, update() and reset() from
+// the main one: the grains of a stroke are generated outside the lock.
 //--------------------------------------------------------------
 
 struct Grain {
@@ -24,15 +30,16 @@ class SandLine {
         void set_mode(int mode);
         void enable_draw(bool val);
         void reset(); // used after saving an artwork
+        vector <int> take_dirty_tiles(); // tiles touched since the last call (used by the autosave)
 
         ofFbo fbo;
         int current_mode;
         // used in bezier mode
-        deque <Grain> sand_grains;
+        deque <Grain, vv_memory::CountingAllocator<Grain, vv_memory::SAND_GRAINS> > sand_grains;
         deque <ofPoint> main_sand_points;
         // used in attractor mode
         ofPoint latest_target;
-        ofVec2f acceleration, velocity, position;
+        WalkerSwarm swarm;
 
         // drawing modes
         static const int BEZIER_MODE = 1;
@@ -41,7 +48,22 @@ class SandLine {
         // for getting gaussian distribution
         std::default_random_engine generator;
 
+        // grains at each of the 200 steps of a bezier stroke (set by the QualityGovernor)
+        std::atomic<int> grains_per_step;
+
+        // the canvas is split in tiles of this size for the autosave
+        static const int TILE_SIZE = 128;
+
     private:
+        void mark_dirty(float x1, float y1, float x2, float y2);
+
+        std::mutex _mutex; // everything above, between add_point() and the main thread
         bool _enable_draw;
         float _max_size, _max_alpha;
+        // dirty tiles bookkeeping
+        int _tiles_cols, _tiles_rows;
+        vector <bool> _dirty_tiles;
+        // bounding box of the strokes added but not drawn yet, marked by update()
+        bool _has_pending;
+        float _pending_x1, _pending_y1, _pending_x2, _pending_y2;
 };
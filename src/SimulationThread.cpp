@@ -0,0 +1,173 @@
+#include "SimulationThread.h"
+
+//--------------------------------------------------------------
+SimulationThread::SimulationThread(){
+    _dt = 1 / 45.0f;
+    max_catch_up = 5;
+    _stats = SimulationStats();
+    _max_step_ms = 0;
+    _max_step_time = 0;
+}
+
+//--------------------------------------------------------------
+// @args:   rate: ticks per second
+//          step: advances the simulation by dt seconds and fills the snapshot,
+//          called on the simulation thread only
+//--------------------------------------------------------------
+void SimulationThread::setup(float rate, std::function<void(SimSnapshot & next, float dt)> step){
+
+    _dt = 1 / rate;
+    _step = step;
+    _stats.rate = rate;
+    startThread();
+}
+
+//--------------------------------------------------------------
+void SimulationThread::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopThread();
+        _condition.notify_all();
+    }
+    waitForThread(false);
+}
+
+//--------------------------------------------------------------
+// @desc:   the state of the simulation one tick ago, blended between the two
+//          snapshots around it: the camera (its orientation slerped, so it
+//          never goes the long way around) and the fireworks not exploded
+//          yet, matched by id. The particles are not blended, out points to
+//          the ones of the latest snapshot.
+// @args:   out: left as it is until the first snapshot is published
+//--------------------------------------------------------------
+void SimulationThread::get_interpolated(SimView & out){
+
+    std::shared_ptr <const SimSnapshot> previous, latest;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        previous = _previous;
+        latest = _latest;
+    }
+    if (!latest) return;
+
+    float t = 1;
+    if (previous){
+        double render_time = ofGetElapsedTimeMicros() / 1000000.0 - _dt;
+        t = ofClamp((render_time - previous->time) / (latest->time - previous->time), 0, 1);
+    }
+    else previous = latest;
+
+    out.tick = latest->tick;
+    out.snapshot = latest;
+    out.cam_position = previous->cam_position.getInterpolated(latest->cam_position, t);
+    out.cam_orientation.slerp(t, previous->cam_orientation, latest->cam_orientation);
+    out.cam_move_velocity = previous->cam_move_velocity.getInterpolated(latest->cam_move_velocity, t);
+
+    out.fireworks.resize(latest->fireworks.size());
+    for (int f = 0; f < latest->fireworks.size(); f++){
+
+        const FireworkState & firework = latest->fireworks[f];
+        FireworkView & view = out.fireworks[f];
+        view.exploded = firework.exploded;
+        view.position = firework.position;
+        view.mesh = &firework.mesh;
+        if (firework.exploded) continue;
+
+        for (int p = 0; p < previous->fireworks.size(); p++){
+            if (previous->fireworks[p].id == firework.id){
+                if (!previous->fireworks[p].exploded) view.position = previous->fireworks[p].position.getInterpolated(firework.position, t);
+                break;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+// @desc:   a snapshot nobody else holds anymore (neither published nor in a
+//          SimView), or a new one the first few ticks
+//--------------------------------------------------------------
+std::shared_ptr <SimSnapshot> SimulationThread::get_free_snapshot(){
+
+    for (int s = 0; s < _pool.size(); s++){
+        if (_pool[s].use_count() == 1){
+            // whatever the render thread did with it is over
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return _pool[s];
+        }
+    }
+    _pool.push_back(std::make_shared<SimSnapshot>());
+    return _pool.back();
+}
+
+//--------------------------------------------------------------
+SimulationStats SimulationThread::get_stats(){
+    std::unique_lock<std::mutex> lock(mutex);
+    return _stats;
+}
+
+//--------------------------------------------------------------
+// @desc:   a tick every 1/rate seconds, on a fixed timeline: after a slow
+//          step the next ones run back to back to catch up, at most
+//          max_catch_up of them, the rest is dropped and the timeline restarts
+//--------------------------------------------------------------
+void SimulationThread::threadedFunction(){
+
+    double next_time = ofGetElapsedTimeMicros() / 1000000.0;
+    int tick = 0;
+
+    while (isThreadRunning()){
+
+        double now = ofGetElapsedTimeMicros() / 1000000.0;
+
+        if (now < next_time){
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!isThreadRunning()) break;
+            _condition.wait_for(lock, std::chrono::microseconds(int64_t((next_time - now) * 1000000)));
+            continue;
+        }
+
+        int steps = 0;
+        while (now >= next_time && steps < max_catch_up && isThreadRunning()){
+
+            uint64_t start_time = ofGetElapsedTimeMicros();
+
+            // the published ones are shared with the render thread, this one isn't yet
+            std::shared_ptr <SimSnapshot> next = get_free_snapshot();
+            _step(*next, _dt);
+            next->tick = tick++;
+            next->time = next_time;
+
+            float step_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+            vv_metrics::observe(vv_metrics::SIM_STEP_MS, step_ms);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                _previous = _latest;
+                _latest = next;
+
+                _stats.ticks++;
+                _stats.last_step_ms = step_ms;
+                _max_step_ms = std::max(_max_step_ms, step_ms);
+                if (now - _max_step_time > 1){
+                    _stats.max_step_ms = _max_step_ms;
+                    _max_step_ms = 0;
+                    _max_step_time = now;
+                }
+            }
+
+            next_time += _dt;
+            steps++;
+        }
+
+        // too far behind, forget the missed ticks
+        if (now >= next_time){
+            int dropped = int((now - next_time) / _dt) + 1;
+            vv_metrics::increment(vv_metrics::SIM_TICKS_DROPPED, dropped);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                _stats.dropped_ticks += dropped;
+            }
+            next_time += dropped * _dt;
+        }
+    }
+}
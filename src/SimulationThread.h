@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_metrics.h"
+
+//--------------------------------------------------------------
+// Runs the simulation (camera physics, fireworks, tweet handling) at a fixed
+// rate on its own thread, so a slow frame or a burst of tweets doesn't change
+// how fast things move, and the render thread never waits for them.
+// Every tick fills a SimSnapshot that is never touched again once
+// published: the render thread keeps the last two and draws in between,
+// one tick behind (see get_interpolated()). Snapshots are recycled once
+// nobody holds them anymore, so a tick allocates nothing.
+// The render thread only interpolates the camera and where the fireworks
+// are into its SimView, the particles are drawn from the latest snapshot.
+//
+// @example:
+//
+// void ofApp::setup(){
+//     simulation.setup(45, [this](SimSnapshot & next, float dt){ simulate(next, dt); });
+// }
+//
+// void ofApp::update(){
+//     simulation.get_interpolated(view_state);
+// }
+//--------------------------------------------------------------
+
+struct FireworkState {
+    int id; // to match the same firework in two snapshots
+    bool exploded;
+    ofPoint position; // of the initial particle, before the explosion
+    ofMesh mesh; // the particles, after
+};
+
+// filled by the step function, whatever it doesn't set keeps the values of
+// an older tick (the snapshots are reused)
+struct SimSnapshot {
+    int tick;
+    double time; // seconds, of the tick as scheduled
+    ofPoint cam_position;
+    ofQuaternion cam_orientation;
+    ofVec3f cam_move_velocity;
+    vector <FireworkState> fireworks;
+};
+
+struct FireworkView {
+    bool exploded;
+    ofPoint position; // interpolated, before the explosion
+    const ofMesh * mesh; // the particles of the latest tick, after
+};
+
+// what the render thread draws: the blended transforms, and the snapshot
+// the meshes belong to (held, so it's not recycled meanwhile)
+struct SimView {
+    int tick;
+    ofPoint cam_position;
+    ofQuaternion cam_orientation;
+    ofVec3f cam_move_velocity;
+    vector <FireworkView> fireworks; // reused every frame
+    std::shared_ptr <const SimSnapshot> snapshot;
+};
+
+struct SimulationStats {
+    float rate; // ticks per second
+    int ticks; // since the start
+    int dropped_ticks; // too late to catch up
+    float last_step_ms;
+    float max_step_ms; // over the last second
+};
+
+class SimulationThread : public ofThread {
+
+    public:
+
+        SimulationThread();
+
+        void setup(float rate, std::function<void(SimSnapshot & next, float dt)> step);
+        void stop();
+
+        void get_interpolated(SimView & out); // render thread
+        SimulationStats get_stats();
+
+        int max_catch_up; // ticks in a row, then the late ones are dropped
+
+    private:
+
+        void threadedFunction();
+        std::shared_ptr <SimSnapshot> get_free_snapshot();
+
+        std::function<void(SimSnapshot &, float)> _step;
+        float _dt;
+        std::condition_variable _condition;
+
+        // published, immutable
+        std::shared_ptr <const SimSnapshot> _previous, _latest;
+        // every snapshot ever made, simulation thread only
+        vector <std::shared_ptr<SimSnapshot> > _pool;
+
+        SimulationStats _stats;
+        float _max_step_ms, _max_step_time;
+};
@@ -0,0 +1,369 @@
+#include "TaskScheduler.h"
+
+// the worker the current thread is, -1 for any other thread
+static thread_local TaskScheduler * current_scheduler = NULL;
+static thread_local int current_worker = -1;
+
+//--------------------------------------------------------------
+// TASK GRAPH
+//--------------------------------------------------------------
+TaskGraph::TaskGraph(){
+    _wall_ms = 0;
+}
+
+//--------------------------------------------------------------
+// @args:   main_thread: only the thread calling TaskScheduler::run() runs it (gl calls)
+// @return: the id of the task, for the dependencies of the next ones
+//--------------------------------------------------------------
+int TaskGraph::add(std::string name, std::function<void()> work, vector<int> dependencies, bool main_thread){
+
+    int id = _nodes.size();
+    _nodes.emplace_back();
+    Node & node = _nodes.back();
+    node.name = name;
+    node.work = work;
+    node.main_thread = main_thread;
+    node.start_time = 0;
+    node.end_time = 0;
+
+    for (int d = 0; d < dependencies.size(); d++){
+        if (dependencies[d] < 0 || dependencies[d] >= id) continue;
+        node.dependencies.push_back(dependencies[d]);
+        _nodes[dependencies[d]].dependents.push_back(id);
+    }
+    node.remaining = node.dependencies.size();
+
+    return id;
+}
+
+//--------------------------------------------------------------
+void TaskGraph::clear(){
+    _nodes.clear();
+}
+
+//--------------------------------------------------------------
+int TaskGraph::size(){
+    return _nodes.size();
+}
+
+//--------------------------------------------------------------
+std::string TaskGraph::get_name(int task){
+    return _nodes[task].name;
+}
+
+//--------------------------------------------------------------
+float TaskGraph::get_ms(int task){
+    return (_nodes[task].end_time - _nodes[task].start_time) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+float TaskGraph::get_wall_ms(){
+    return _wall_ms;
+}
+
+//--------------------------------------------------------------
+float TaskGraph::get_serial_ms(){
+    float ms = 0;
+    for (int t = 0; t < _nodes.size(); t++) ms += get_ms(t);
+    return ms;
+}
+
+//--------------------------------------------------------------
+// the tasks are added after their dependencies, so a single pass is enough
+//--------------------------------------------------------------
+float TaskGraph::get_critical_ms(){
+
+    vector <float> finish(_nodes.size(), 0);
+    float critical = 0;
+    for (int t = 0; t < _nodes.size(); t++){
+        float start = 0;
+        for (int d = 0; d < _nodes[t].dependencies.size(); d++){
+            start = std::max(start, finish[_nodes[t].dependencies[d]]);
+        }
+        finish[t] = start + get_ms(t);
+        critical = std::max(critical, finish[t]);
+    }
+    return critical;
+}
+
+//--------------------------------------------------------------
+float TaskGraph::get_speedup(){
+    return _wall_ms > 0 ? get_serial_ms() / _wall_ms : 1;
+}
+
+//--------------------------------------------------------------
+float TaskGraph::get_overhead_ms(){
+    return std::max(0.0f, _wall_ms - get_critical_ms());
+}
+
+//--------------------------------------------------------------
+// TASK SCHEDULER
+//--------------------------------------------------------------
+TaskScheduler::TaskScheduler(){
+    _num_queued = 0;
+    _stopping = false;
+    _next_queue = 0;
+    _num_tasks = 0;
+    _num_steals = 0;
+}
+
+//--------------------------------------------------------------
+TaskScheduler::~TaskScheduler(){
+    stop();
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::start(int num_workers){
+
+    if (!_threads.empty()) return;
+
+    if (num_workers < 0) num_workers = std::thread::hardware_concurrency() - 1;
+    num_workers = std::max(1, num_workers);
+
+    _stopping = false;
+    for (int w = 0; w < num_workers; w++){
+        _workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (int w = 0; w < num_workers; w++){
+        _threads.push_back(std::thread(&TaskScheduler::worker, this, w));
+    }
+}
+
+//--------------------------------------------------------------
+// the tasks still queued are dropped, nobody is waiting for them anymore
+//--------------------------------------------------------------
+void TaskScheduler::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _stopping = true;
+    }
+    _sleep_condition.notify_all();
+
+    for (int t = 0; t < _threads.size(); t++){
+        _threads[t].join();
+    }
+    _threads.clear();
+    _workers.clear();
+    _num_queued = 0;
+}
+
+//--------------------------------------------------------------
+// @desc:   starts every task whose dependencies are done, and runs the main
+//          thread ones (plus whatever it can take from the workers) until
+//          the whole graph is over
+//--------------------------------------------------------------
+void TaskScheduler::run(TaskGraph & graph){
+
+    uint64_t start_time = ofGetElapsedTimeMicros();
+    int n = graph._nodes.size();
+
+    std::atomic<int> num_left(n);
+    std::mutex main_mutex;
+    deque <int> main_ready;
+
+    for (int t = 0; t < n; t++){
+        graph._nodes[t].remaining = graph._nodes[t].dependencies.size();
+    }
+
+    std::function<void(int)> schedule, execute;
+
+    schedule = [&](int t){
+        if (graph._nodes[t].main_thread){
+            std::unique_lock<std::mutex> lock(main_mutex);
+            main_ready.push_back(t);
+        }
+        else push([&execute, t](){ execute(t); });
+    };
+
+    execute = [&](int t){
+        TaskGraph::Node & node = graph._nodes[t];
+        node.start_time = ofGetElapsedTimeMicros();
+        if (node.work) node.work();
+        node.end_time = ofGetElapsedTimeMicros();
+
+        for (int d = 0; d < node.dependents.size(); d++){
+            if (--graph._nodes[node.dependents[d]].remaining == 0) schedule(node.dependents[d]);
+        }
+        num_left--;
+    };
+
+    for (int t = 0; t < n; t++){
+        if (graph._nodes[t].dependencies.empty()) schedule(t);
+    }
+
+    while (num_left > 0){
+
+        int main_task = -1;
+        {
+            std::unique_lock<std::mutex> lock(main_mutex);
+            if (!main_ready.empty()){
+                main_task = main_ready.front();
+                main_ready.pop_front();
+            }
+        }
+
+        // the frame tasks only, a chunk of the loader here would be a hitch
+        if (main_task >= 0) execute(main_task);
+        else if (!run_one(false)) std::this_thread::yield();
+    }
+
+    graph._wall_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+}
+
+//--------------------------------------------------------------
+// @desc:   splits [from, to) in chunks of grain items, runs the first one
+//          right away and helps with the others until they're all done
+// @args:   background: work that can wait, the thread calling run() won't take it
+//--------------------------------------------------------------
+void TaskScheduler::parallel_for(int from, int to, int grain, std::function<void(int, int)> body, bool background){
+
+    if (to <= from) return;
+    grain = std::max(1, grain);
+
+    if (_workers.empty() || to - from <= grain){
+        for (int begin = from; begin < to; begin += grain){
+            body(begin, std::min(begin + grain, to));
+        }
+        return;
+    }
+
+    int num_chunks = (to - from + grain - 1) / grain;
+    std::atomic<int> remaining(num_chunks - 1);
+
+    for (int begin = from + grain; begin < to; begin += grain){
+        int end = std::min(begin + grain, to);
+        push([&body, &remaining, begin, end](){
+            body(begin, end);
+            remaining--;
+        }, background);
+    }
+
+    body(from, std::min(from + grain, to));
+
+    // a frame task waiting here only helps with frame tasks, or it could
+    // end up stuck in a chunk of the loader
+    while (remaining > 0){
+        if (!run_one(background || current_scheduler == this)) std::this_thread::yield();
+    }
+}
+
+//--------------------------------------------------------------
+TaskSchedulerStats TaskScheduler::get_stats(){
+
+    TaskSchedulerStats stats;
+    stats.num_workers = _workers.size();
+    stats.tasks = _num_tasks;
+    stats.steals = _num_steals;
+    return stats;
+}
+
+//--------------------------------------------------------------
+int TaskScheduler::get_num_workers(){
+    return _workers.size();
+}
+
+//--------------------------------------------------------------
+// a worker keeps its own tasks, everybody else spreads them around
+//--------------------------------------------------------------
+void TaskScheduler::push(Task task, bool background){
+
+    // not started, do it here and now
+    if (_workers.empty()){
+        task();
+        return;
+    }
+
+    int queue = (current_scheduler == this) ? current_worker : _next_queue++ % _workers.size();
+    {
+        std::unique_lock<std::mutex> lock(_workers[queue]->mutex);
+        if (background) _workers[queue]->background.push_back(task);
+        else _workers[queue]->tasks.push_back(task);
+    }
+    _num_queued++;
+
+    // taking the lock means no worker is between checking _num_queued and going to sleep
+    {
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+    }
+    _sleep_condition.notify_one();
+}
+
+//--------------------------------------------------------------
+// the newest task of our own queue, otherwise the oldest of somebody else's;
+// the background queues only when every frame queue is empty
+//--------------------------------------------------------------
+bool TaskScheduler::pop(Task & task, bool background){
+
+    int n = _workers.size();
+    if (n == 0 || _num_queued == 0) return false;
+
+    int self = (current_scheduler == this) ? current_worker : -1;
+    int first = self >= 0 ? self + 1 : _next_queue++ % n;
+
+    for (int pass = 0; pass < (background ? 2 : 1); pass++){
+
+        if (self >= 0){
+            Worker & worker = *_workers[self];
+            if (pop_from(pass == 0 ? worker.tasks : worker.background, worker.mutex, true, task)) return true;
+        }
+
+        for (int i = 0; i < n; i++){
+            int victim = (first + i) % n;
+            if (victim == self) continue;
+            Worker & worker = *_workers[victim];
+            if (pop_from(pass == 0 ? worker.tasks : worker.background, worker.mutex, false, task)){
+                if (self >= 0) _num_steals++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+// @args:   newest: from the back, otherwise from the front
+//--------------------------------------------------------------
+bool TaskScheduler::pop_from(deque<Task> & tasks, std::mutex & mutex, bool newest, Task & task){
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (tasks.empty()) return false;
+
+    if (newest){
+        task = tasks.back();
+        tasks.pop_back();
+    }
+    else {
+        task = tasks.front();
+        tasks.pop_front();
+    }
+    _num_queued--;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool TaskScheduler::run_one(bool background){
+
+    Task task;
+    if (!pop(task, background)) return false;
+    task();
+    _num_tasks++;
+    return true;
+}
+
+//--------------------------------------------------------------
+void TaskScheduler::worker(int index){
+
+    current_scheduler = this;
+    current_worker = index;
+
+    while (!_stopping){
+
+        if (run_one()) continue;
+
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _sleep_condition.wait(lock, [this](){
+            return _stopping || _num_queued > 0;
+        });
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// A small work-stealing thread pool.
+// Every worker has its own queue: it takes its tasks from the back (the
+// most recent ones, still in cache) and, when it runs out, steals the
+// oldest ones from the front of the others. Whoever waits for the work
+// (run() or parallel_for()) runs tasks too instead of sleeping, so they
+// can be nested: a task can call parallel_for() itself.
+//
+// A TaskGraph describes the phases of a frame and what each one needs to
+// be done first; run() starts every phase as soon as its dependencies are
+// over. Phases that make gl calls are marked main_thread and only run on
+// the thread that called run().
+//
+// parallel_for() can mark its chunks as background work (the loader
+// tessellating a map): only the workers and the thread waiting for them
+// take those, so the main thread never picks one up in the middle of a frame.
+//
+// @example:
+//
+// void ofApp::update(){
+//     graph.clear();
+//     int fade = graph.add("fade", [this](){ layer.decay(dt); });
+//     graph.add("upload", [this](){ layer.upload(); }, {fade}, true);
+//     graph.add("history", [this](){ update_history_view(); });
+//     scheduler.run(graph);
+//     cout << graph.get_speedup() << endl;
+// }
+//--------------------------------------------------------------
+
+class TaskGraph {
+
+    public:
+
+        TaskGraph();
+
+        // dependencies: ids returned by previous calls, so the graph can't have cycles
+        int add(std::string name, std::function<void()> work, vector<int> dependencies = vector<int>(), bool main_thread = false);
+        void clear();
+
+        // timings of the last run()
+        int size();
+        std::string get_name(int task);
+        float get_ms(int task);
+        float get_wall_ms(); // from the start of run() to the end of the last task
+        float get_serial_ms(); // all the tasks one after the other
+        float get_critical_ms(); // the longest chain of dependencies, the best we could do
+        float get_speedup(); // serial / wall
+        float get_overhead_ms(); // wall - critical: waiting in the queues, and the scheduler itself
+
+    private:
+
+        friend class TaskScheduler;
+
+        struct Node {
+            std::string name;
+            std::function<void()> work;
+            vector <int> dependencies, dependents;
+            bool main_thread;
+            std::atomic<int> remaining; // dependencies not done yet
+            uint64_t start_time, end_time; // micros
+        };
+
+        deque <Node> _nodes; // atomics can't be moved, a deque never moves them
+        float _wall_ms;
+};
+
+struct TaskSchedulerStats {
+    int num_workers;
+    uint64_t tasks; // since the start
+    uint64_t steals; // tasks taken from the queue of another worker
+};
+
+class TaskScheduler {
+
+    public:
+
+        TaskScheduler();
+        ~TaskScheduler();
+
+        void start(int num_workers = -1); // -1: one less than the cores, the caller is the last one
+        void stop();
+
+        void run(TaskGraph & graph); // blocks until every task is done
+        void parallel_for(int from, int to, int grain, std::function<void(int, int)> body, bool background = false); // body(begin, end) on chunks of grain
+
+        TaskSchedulerStats get_stats();
+        int get_num_workers();
+
+    private:
+
+        typedef std::function<void()> Task;
+
+        struct Worker {
+            std::mutex mutex;
+            deque <Task> tasks;
+            deque <Task> background; // taken only when there are no frame tasks left
+        };
+
+        void push(Task task, bool background = false);
+        bool pop(Task & task, bool background);
+        bool pop_from(deque<Task> & tasks, std::mutex & mutex, bool newest, Task & task);
+        bool run_one(bool background = true); // a task from any queue, if there's one; background: the background ones too
+        void worker(int index);
+
+        vector <std::thread> _threads;
+        vector <std::unique_ptr<Worker> > _workers;
+
+        // idle workers sleep here
+        std::mutex _sleep_mutex;
+        std::condition_variable _sleep_condition;
+        std::atomic<int> _num_queued;
+        std::atomic<bool> _stopping;
+        std::atomic<uint32_t> _next_queue; // round robin, for tasks pushed from outside the pool
+
+        std::atomic<uint64_t> _num_tasks, _num_steals;
+};
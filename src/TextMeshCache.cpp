@@ -0,0 +1,132 @@
+#include "TextMeshCache.h"
+
+//--------------------------------------------------------------
+TextMeshCache::TextMeshCache(){
+    _num_layouts = 0;
+}
+
+//--------------------------------------------------------------
+// @args:   slot: name of the slot, the same slot is reused across frames
+//          font: the font, it must outlive the cache
+//          text, x, y: same arguments of ofTrueTypeFont::drawString()
+//--------------------------------------------------------------
+void TextMeshCache::set(std::string slot, ofTrueTypeFont & font, std::string text, float x, float y){
+
+    // the vertical flip depends on where we're drawing (screen or fbo)
+    bool v_flipped = ofIsVFlipped();
+
+    std::map <std::string, Slot>::iterator it = _slots.find(slot);
+
+    if (it != _slots.end()){
+        Slot & current = it->second;
+        if (current.font == &font && current.text == text && current.x == x && current.y == y && current.v_flipped == v_flipped){
+            return;
+        }
+        // the old font batch needs to lose this string
+        get_batch(current.font).dirty = true;
+    }
+
+    Slot new_slot;
+    new_slot.font = &font;
+    new_slot.text = text;
+    new_slot.x = x;
+    new_slot.y = y;
+    new_slot.v_flipped = v_flipped;
+    _slots[slot] = new_slot;
+
+    get_batch(&font).dirty = true;
+}
+
+//--------------------------------------------------------------
+// one draw call per font, the batches are rebuilt only when one of their strings changed
+//--------------------------------------------------------------
+void TextMeshCache::draw(){
+
+    for (int b = 0; b < _batches.size(); b++){
+
+        Batch & batch = _batches.at(b);
+
+        if (batch.dirty){
+
+            batch.mesh.clear();
+            batch.mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+
+            for (std::map <std::string, Slot>::iterator it = _slots.begin(); it != _slots.end(); ++it){
+
+                Slot & slot = it->second;
+                if (slot.font != batch.font || slot.text.empty()) continue;
+
+                const ofMesh & layout = get_layout(slot.font, slot.text, slot.v_flipped);
+
+                // layouts are at the origin, move them where the slot wants them
+                ofIndexType first = batch.mesh.getNumVertices();
+                const vector <ofVec3f> & vertices = layout.getVertices();
+                for (int v = 0; v < vertices.size(); v++){
+                    batch.mesh.addVertex(vertices[v] + ofVec3f(slot.x, slot.y, 0));
+                }
+                const vector <ofVec2f> & tex_coords = layout.getTexCoords();
+                batch.mesh.getTexCoords().insert(batch.mesh.getTexCoords().end(), tex_coords.begin(), tex_coords.end());
+                const vector <ofIndexType> & indices = layout.getIndices();
+                for (int i = 0; i < indices.size(); i++){
+                    batch.mesh.addIndex(first + indices[i]);
+                }
+            }
+
+            batch.dirty = false;
+        }
+
+        if (batch.mesh.getNumVertices() == 0) continue;
+
+        batch.font->getFontTexture().bind();
+        batch.mesh.draw();
+        batch.font->getFontTexture().unbind();
+    }
+}
+
+//--------------------------------------------------------------
+void TextMeshCache::clear(){
+    _slots.clear();
+    for (int b = 0; b < _batches.size(); b++){
+        _batches.at(b).mesh.clear();
+        _batches.at(b).dirty = false;
+    }
+}
+
+//--------------------------------------------------------------
+int TextMeshCache::get_num_layouts(){
+    return _num_layouts;
+}
+
+//--------------------------------------------------------------
+// @return: the glyph quads of the string laid out at the origin
+//--------------------------------------------------------------
+const ofMesh & TextMeshCache::get_layout(ofTrueTypeFont * font, const std::string & text, bool v_flipped){
+
+    // the flip is part of the key too, a leading marker keeps it in the string
+    std::pair<ofTrueTypeFont *, std::string> key(font, (v_flipped ? "1" : "0") + text);
+
+    std::map <std::pair<ofTrueTypeFont *, std::string>, ofMesh>::iterator it = _layouts.find(key);
+    if (it != _layouts.end()) return it->second;
+
+    // keep the cache bounded, strings still in use get laid out again on the next rebuild
+    if (_layouts.size() >= MAX_CACHED_LAYOUTS) _layouts.clear();
+
+    _num_layouts++;
+    ofMesh & layout = _layouts[key];
+    layout = font->getStringMesh(text, 0, 0, v_flipped);
+    return layout;
+}
+
+//--------------------------------------------------------------
+TextMeshCache::Batch & TextMeshCache::get_batch(ofTrueTypeFont * font){
+
+    for (int b = 0; b < _batches.size(); b++){
+        if (_batches.at(b).font == font) return _batches.at(b);
+    }
+
+    Batch batch;
+    batch.font = font;
+    batch.dirty = true;
+    _batches.push_back(batch);
+    return _batches.back();
+}
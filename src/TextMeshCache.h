@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ofMain.h"
+
+//--------------------------------------------------------------
+// Lays out strings once and keeps their glyph quads around.
+// Each named slot holds a string drawn at a given position with a given font:
+// set() is cheap when nothing changed, and draw() submits one single
+// batched mesh per font instead of a drawString() per string.
+// Layouts are cached by (font, string), so strings coming back (like recurring hashtags)
+// don't need to be laid out again.
+//
+// @example:
+//
+// void ofApp::draw(){
+//     text_cache.set("city", font, current_tweeted_city, 20, 30);
+//     text_cache.set("fps", font, "fps: " + ofToString(int(ofGetFrameRate())), 20, 50);
+//     text_cache.draw();
+// }
+//--------------------------------------------------------------
+
+class TextMeshCache {
+
+    public:
+
+        TextMeshCache();
+
+        void set(std::string slot, ofTrueTypeFont & font, std::string text, float x, float y);
+        void draw();
+        void clear();
+
+        int get_num_layouts(); // number of strings laid out since the start
+
+        static const int MAX_CACHED_LAYOUTS = 256;
+
+    private:
+
+        struct Slot {
+            ofTrueTypeFont * font;
+            std::string text;
+            float x, y;
+            bool v_flipped;
+        };
+
+        struct Batch {
+            ofTrueTypeFont * font;
+            ofVboMesh mesh;
+            bool dirty;
+        };
+
+        const ofMesh & get_layout(ofTrueTypeFont * font, const std::string & text, bool v_flipped);
+        Batch & get_batch(ofTrueTypeFont * font);
+
+        std::map <std::string, Slot> _slots;
+        std::map <std::pair<ofTrueTypeFont *, std::string>, ofMesh> _layouts;
+        vector <Batch> _batches;
+        int _num_layouts;
+};
@@ -0,0 +1,196 @@
+#include "TileAutosave.h"
+
+//--------------------------------------------------------------
+// @args:   directory: where the tiles are stored, relative to bin/data
+//          canvas_w, canvas_h: size of the artwork fbo
+//          tile_size: side in pixels of each tile (must match SandLine::TILE_SIZE)
+//--------------------------------------------------------------
+void TileAutosave::setup(std::string directory, int canvas_w, int canvas_h, int tile_size){
+
+    _directory = directory;
+    _canvas_w = canvas_w;
+    _canvas_h = canvas_h;
+    _tile_size = tile_size;
+    _cols = (canvas_w + tile_size - 1) / tile_size;
+    _rows = (canvas_h + tile_size - 1) / tile_size;
+    _num_written = 0;
+    _num_checkpoints = 0;
+    _generation = 0;
+
+    ofDirectory::createDirectory(_directory, true, true);
+
+    startThread();
+}
+
+//--------------------------------------------------------------
+// Reads back only the given tiles (indices are row * cols + col)
+// and queues them for the writer thread. Needs the GL context, so call it
+// from update() or draw().
+//--------------------------------------------------------------
+void TileAutosave::checkpoint(ofFbo & fbo, const vector<int> & tiles){
+
+    if (tiles.empty()) return;
+
+    // resolve the multisampled fbo and read from the resolved one
+    fbo.updateTexture(0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.getIdDrawBuffer());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    deque <DirtyTile> read_tiles;
+
+    for (int i = 0; i < tiles.size(); i++){
+
+        DirtyTile tile;
+        tile.col = tiles.at(i) % _cols;
+        tile.row = tiles.at(i) / _cols;
+
+        int x = tile.col * _tile_size;
+        int y = tile.row * _tile_size;
+        // tiles on the right and bottom edges can be smaller
+        int w = std::min(_tile_size, _canvas_w - x);
+        int h = std::min(_tile_size, _canvas_h - y);
+
+        // the fbo is stored with the same orientation as the canvas,
+        // so the tile coordinates can be used as they are
+        tile.pixels.allocate(w, h, OF_IMAGE_COLOR_ALPHA);
+        glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, tile.pixels.getData());
+
+        read_tiles.push_back(tile);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int i = 0; i < read_tiles.size(); i++){
+        read_tiles.at(i).generation = _generation;
+        _queue.push_back(read_tiles.at(i));
+    }
+    _num_checkpoints++;
+    _condition.notify_one();
+}
+
+//--------------------------------------------------------------
+// Draws all the stored tiles back into the given fbo.
+// @return: true if a previous session was found
+//--------------------------------------------------------------
+bool TileAutosave::restore(ofFbo & fbo){
+
+    if (!ofFile::doesFileExist(_directory + "/manifest.txt")) return false;
+
+    int restored = 0;
+
+    fbo.begin();
+    ofPushStyle();
+    ofSetColor(255);
+    for (int row = 0; row < _rows; row++){
+        for (int col = 0; col < _cols; col++){
+
+            std::string path = tile_path(col, row);
+            if (!ofFile::doesFileExist(path)) continue;
+
+            ofImage tile;
+            if (tile.load(path)){
+                tile.draw(col * _tile_size, row * _tile_size);
+                restored++;
+            }
+        }
+    }
+    ofPopStyle();
+    fbo.end();
+
+    cout << "TileAutosave::restore: restored " << restored << " tiles from " << _directory << endl;
+
+    return restored > 0;
+}
+
+//--------------------------------------------------------------
+void TileAutosave::clear_store(){
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // whatever is still queued or being written belongs to the artwork we're throwing away
+    _queue.clear();
+    _generation++;
+
+    for (int row = 0; row < _rows; row++){
+        for (int col = 0; col < _cols; col++){
+            std::string path = tile_path(col, row);
+            if (ofFile::doesFileExist(path)) ofFile::removeFile(path);
+        }
+    }
+    ofFile::removeFile(_directory + "/manifest.txt");
+}
+
+//--------------------------------------------------------------
+void TileAutosave::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopThread();
+        _condition.notify_all();
+    }
+    // the queue gets flushed before the thread exits
+    waitForThread(false);
+}
+
+//--------------------------------------------------------------
+int TileAutosave::get_num_written(){
+    std::unique_lock<std::mutex> lock(mutex);
+    return _num_written;
+}
+
+//--------------------------------------------------------------
+int TileAutosave::get_num_pending(){
+    std::unique_lock<std::mutex> lock(mutex);
+    return _queue.size();
+}
+
+//--------------------------------------------------------------
+void TileAutosave::threadedFunction(){
+
+    while (true){
+
+        DirtyTile tile;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (_queue.empty() && isThreadRunning()){
+                _condition.wait(lock);
+            }
+            if (_queue.empty()) break;
+
+            tile = _queue.front();
+            _queue.pop_front();
+        }
+
+        // write to a temp file first so a crash mid-write never leaves a broken tile
+        std::string path = tile_path(tile.col, tile.row);
+        ofSaveImage(tile.pixels, path + ".tmp.png");
+
+        // the store may have been cleared while encoding: the tile only
+        // goes in place if it still belongs to the current artwork
+        std::unique_lock<std::mutex> lock(mutex);
+        if (tile.generation != _generation){
+            ofFile::removeFile(path + ".tmp.png");
+            continue;
+        }
+        ofFile::moveFromTo(path + ".tmp.png", path, true, true);
+        _num_written++;
+        if (_queue.empty()) write_manifest();
+    }
+}
+
+//--------------------------------------------------------------
+std::string TileAutosave::tile_path(int col, int row){
+    return _directory + "/tile_" + ofToString(col) + "_" + ofToString(row) + ".png";
+}
+
+//--------------------------------------------------------------
+// called with the mutex held
+//--------------------------------------------------------------
+void TileAutosave::write_manifest(){
+
+    ofBuffer manifest;
+    manifest.append("canvas " + ofToString(_canvas_w) + " " + ofToString(_canvas_h) + "\n");
+    manifest.append("tile_size " + ofToString(_tile_size) + "\n");
+    manifest.append("checkpoints " + ofToString(_num_checkpoints) + "\n");
+    ofBufferToFile(_directory + "/manifest.txt", manifest);
+}
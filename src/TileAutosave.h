@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+
+//--------------------------------------------------------------
+// Periodic crash-safe checkpoint of the artwork canvas.
+// The canvas is split in square tiles: only the tiles that were touched
+// since the last checkpoint are read back from the fbo and handed to a
+// background thread that writes them as png files inside the tile store.
+// The cost of a checkpoint scales with how much was drawn, not with the canvas size.
+//--------------------------------------------------------------
+
+struct DirtyTile {
+    int col, row;
+    int generation; // of the store when it was read back
+    ofPixels pixels;
+};
+
+class TileAutosave : public ofThread {
+
+    public:
+
+        void setup(std::string directory, int canvas_w, int canvas_h, int tile_size);
+        void checkpoint(ofFbo & fbo, const vector<int> & tiles);
+        bool restore(ofFbo & fbo); // used at startup after a crash
+        void clear_store(); // used after saving an artwork
+        void stop();
+
+        int get_num_written();
+        int get_num_pending();
+
+    private:
+
+        void threadedFunction();
+        std::string tile_path(int col, int row);
+        void write_manifest();
+
+        std::string _directory;
+        int _canvas_w, _canvas_h, _tile_size;
+        int _cols, _rows;
+
+        // shared with the writer thread, guarded by ofThread::mutex
+        deque <DirtyTile> _queue;
+        std::condition_variable _condition;
+        int _num_written;
+        int _num_checkpoints;
+        int _generation; // bumped by clear_store(), older tiles are thrown away
+};
@@ -0,0 +1,284 @@
+#include "TileStreamer.h"
+
+//--------------------------------------------------------------
+// @args:   directory: the pyramid written by vv_tile_pyramid::build()
+//          memory_cap: max bytes for the resident tiles (cpu + gpu copies)
+// @return: false if there is no pyramid in the directory, the streamer stays disabled
+//--------------------------------------------------------------
+bool TileStreamer::setup(std::string directory, size_t memory_cap){
+
+    _directory = directory;
+    _memory_cap = memory_cap;
+    _stats = TileStreamerStats();
+    uploads_per_frame = 2;
+    prefetch_time = 1.5f;
+    lod_bias = 0;
+
+    _enabled = vv_tile_pyramid::read_manifest(directory, _bounds, _max_zoom);
+    if (!_enabled) return false;
+
+    cout << "TileStreamer::setup: pyramid with " << (_max_zoom + 1) << " zoom levels in " << directory << endl;
+
+    // the root right away, it's what gets drawn where nothing else arrived yet
+    TileKey root = {0, 0, 0};
+    Tile tile;
+    tile.geometry = load_tile(root);
+    tile.last_used = ofGetFrameNum();
+    tile.bytes = 0;
+    if (tile.geometry){
+        tile.geometry->upload();
+        tile.bytes = tile.geometry->get_cpu_bytes() + tile.geometry->get_gpu_bytes();
+    }
+    _resident[root] = tile;
+    _stats.loaded++;
+
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+// @args:   cam_position, look_dir: where the camera is and where it's looking, in map coordinates
+//          velocity: camera movement per frame, used to prefetch
+//          fov: vertical field of view, in degrees
+//--------------------------------------------------------------
+void TileStreamer::update(ofVec3f cam_position, ofVec3f look_dir, ofVec3f velocity, float fov){
+
+    if (!_enabled) return;
+
+    uint64_t frame = ofGetFrameNum();
+
+    // 1. where the camera looks at on the map plane (z = 0), and how much of it can be seen
+    float height = std::max(1.0f, fabs(cam_position.z));
+    ofVec2f center(cam_position.x, cam_position.y);
+    if (look_dir.z < -0.01f){
+        float t = -cam_position.z / look_dir.z;
+        center = ofVec2f(cam_position.x + look_dir.x * t, cam_position.y + look_dir.y * t);
+        height = t;
+    }
+    float radius = height * tan(ofDegToRad(fov * 0.5f)) * 2.0f; // a bit more than the viewport, it's wider than tall
+
+    // the zoom where a tile is about as big as the visible area
+    int z = ofClamp(floor(log2(std::max(_bounds.getWidth(), _bounds.getHeight()) / radius)) - lod_bias, 0, _max_zoom);
+
+    std::set <TileKey> needed;
+    add_tiles_around(center, radius, z, needed);
+    _in_view.assign(needed.begin(), needed.end());
+
+    // prefetch where the camera is going (velocity is per frame, at about 45 fps)
+    std::set <TileKey> ahead_tiles;
+    ofVec2f ahead = center + ofVec2f(velocity.x, velocity.y) * (prefetch_time * 45);
+    add_tiles_around(ahead, radius, z, ahead_tiles);
+
+    vector <TileKey> order(_in_view);
+    for (std::set <TileKey>::iterator it = ahead_tiles.begin(); it != ahead_tiles.end(); ++it){
+        if (needed.insert(*it).second) order.push_back(*it);
+    }
+
+    // 2. ask for the missing tiles, the ones in view first; what's still queued
+    // from the previous frames and isn't needed anymore is dropped, the rest
+    // goes back in the queue in the new order
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        std::set <TileKey> queued;
+        for (int r = 0; r < _requests.size(); r++){
+            if (needed.count(_requests[r]) > 0) queued.insert(_requests[r]);
+            else _requested.erase(_requests[r]);
+        }
+        _requests.clear();
+
+        for (int t = 0; t < order.size(); t++){
+            std::map <TileKey, Tile>::iterator it = _resident.find(order[t]);
+            if (it != _resident.end()){
+                it->second.last_used = frame;
+            }
+            else if (queued.count(order[t]) > 0 || _requested.count(order[t]) == 0){
+                // not being read right now
+                _requested.insert(order[t]);
+                _requests.push_back(order[t]);
+            }
+        }
+        _condition.notify_one();
+    }
+
+    // 3. upload only a few of the tiles that arrived, to avoid frame hitches
+    for (int u = 0; u < uploads_per_frame; u++){
+
+        LoadedTile loaded;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (_loaded.empty()) break;
+            loaded = _loaded.front();
+            _loaded.pop_front();
+        }
+
+        _requested.erase(loaded.key);
+
+        Tile tile;
+        tile.geometry = loaded.geometry;
+        tile.last_used = frame;
+        if (tile.geometry){
+            tile.geometry->upload();
+            tile.bytes = tile.geometry->get_cpu_bytes() + tile.geometry->get_gpu_bytes();
+        }
+        else {
+            // empty tiles are remembered too, so they're not requested again
+            tile.bytes = 0;
+        }
+        _resident[loaded.key] = tile;
+        _stats.loaded++;
+    }
+
+    evict();
+
+    // stats
+    _stats.resident = _resident.size();
+    _stats.pending = _requested.size();
+    _stats.in_view = _in_view.size();
+    _stats.bytes = 0;
+    for (std::map <TileKey, Tile>::iterator it = _resident.begin(); it != _resident.end(); ++it){
+        _stats.bytes += it->second.bytes;
+    }
+}
+
+//--------------------------------------------------------------
+void TileStreamer::draw(){
+
+    if (!_enabled) return;
+
+    std::set <TileKey> drawn;
+
+    for (int i = 0; i < _in_view.size(); i++){
+
+        // the tile itself or, while it's loading, its closest loaded parent
+        TileKey key = _in_view[i];
+        while (_resident.count(key) == 0 && key.z > 0){
+            key.z--;
+            key.x /= 2;
+            key.y /= 2;
+        }
+
+        std::map <TileKey, Tile>::iterator it = _resident.find(key);
+        if (it == _resident.end() || drawn.count(key) > 0) continue;
+        drawn.insert(key);
+
+        if (it->second.geometry) it->second.geometry->draw_all();
+    }
+}
+
+//--------------------------------------------------------------
+void TileStreamer::stop(){
+
+    if (!_enabled) return;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopThread();
+        _condition.notify_all();
+    }
+    waitForThread(false);
+}
+
+//--------------------------------------------------------------
+bool TileStreamer::is_enabled(){
+    return _enabled;
+}
+
+//--------------------------------------------------------------
+TileStreamerStats TileStreamer::get_stats(){
+    return _stats;
+}
+
+//--------------------------------------------------------------
+// reads and quantizes the requested tiles, one at a time
+//--------------------------------------------------------------
+void TileStreamer::threadedFunction(){
+
+    while (isThreadRunning()){
+
+        TileKey key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (_requests.empty() && isThreadRunning()){
+                _condition.wait(lock);
+            }
+            if (!isThreadRunning()) break;
+
+            key = _requests.front();
+            _requests.pop_front();
+        }
+
+        LoadedTile loaded;
+        loaded.key = key;
+        loaded.geometry = load_tile(key);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        _loaded.push_back(loaded);
+    }
+}
+
+//--------------------------------------------------------------
+// reads a tile and quantizes it, no gl calls
+//--------------------------------------------------------------
+shared_ptr <QuantizedGeometry> TileStreamer::load_tile(TileKey key){
+
+    vector <ofMesh> rings;
+    if (!vv_tile_pyramid::read_tile(ofToDataPath(vv_tile_pyramid::tile_path(_directory, key)), rings) || rings.empty()){
+        return shared_ptr<QuantizedGeometry>();
+    }
+
+    shared_ptr <QuantizedGeometry> geometry = make_shared<QuantizedGeometry>();
+    geometry->palette.push_back(ofFloatColor(0.0));
+    // a tile is small enough for a single quantized part
+    vector <const ofMesh *> parts;
+    for (int r = 0; r < rings.size(); r++) parts.push_back(&rings[r]);
+    geometry->add_part(parts, 0);
+    return geometry;
+}
+
+//--------------------------------------------------------------
+void TileStreamer::add_tiles_around(ofVec2f center, float radius, int z, std::set<TileKey> & tiles){
+
+    int n_tiles = 1 << z;
+    float tile_w = _bounds.getWidth() / n_tiles;
+    float tile_h = _bounds.getHeight() / n_tiles;
+
+    int x_1 = ofClamp(floor((center.x - radius - _bounds.x) / tile_w), 0, n_tiles - 1);
+    int x_2 = ofClamp(floor((center.x + radius - _bounds.x) / tile_w), 0, n_tiles - 1);
+    int y_1 = ofClamp(floor((center.y - radius - _bounds.y) / tile_h), 0, n_tiles - 1);
+    int y_2 = ofClamp(floor((center.y + radius - _bounds.y) / tile_h), 0, n_tiles - 1);
+
+    for (int y = y_1; y <= y_2; y++){
+        for (int x = x_1; x <= x_2; x++){
+            TileKey key = {z, x, y};
+            tiles.insert(key);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+// drops the least recently used tiles until we're under the cap,
+// never the ones in view and never the root (loaded by setup(), the fallback for everything)
+//--------------------------------------------------------------
+void TileStreamer::evict(){
+
+    size_t bytes = 0;
+    for (std::map <TileKey, Tile>::iterator it = _resident.begin(); it != _resident.end(); ++it){
+        bytes += it->second.bytes;
+    }
+    if (bytes <= _memory_cap) return;
+
+    vector <std::pair<uint64_t, TileKey> > candidates;
+    uint64_t frame = ofGetFrameNum();
+    for (std::map <TileKey, Tile>::iterator it = _resident.begin(); it != _resident.end(); ++it){
+        if (it->second.last_used == frame || it->first.z == 0) continue;
+        candidates.push_back(std::make_pair(it->second.last_used, it->first));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (int c = 0; c < candidates.size() && bytes > _memory_cap; c++){
+        bytes -= _resident[candidates[c].second].bytes;
+        _resident.erase(candidates[c].second);
+        _stats.evicted++;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_tile_pyramid.h"
+#include "QuantizedGeometry.h"
+#include <set>
+
+//--------------------------------------------------------------
+// Runtime side of vv_tile_pyramid: keeps in memory only the tiles around
+// what the camera is looking at.
+// Every frame update() works out the zoom level and the tiles in view, plus
+// a ring of tiles ahead in the direction the camera is moving, and asks a
+// background thread to read the missing ones. Loaded tiles are quantized on
+// that thread too; the main thread only uploads a few of them per frame.
+// When the resident tiles go over the memory cap the least recently used are evicted.
+// While a tile is loading, its closest loaded parent is drawn instead: the
+// root is loaded by setup() and never evicted, so there's always one.
+//--------------------------------------------------------------
+
+struct TileStreamerStats {
+    int resident, pending, in_view;
+    int loaded, evicted; // since the start
+    size_t bytes;
+};
+
+class TileStreamer : public ofThread {
+
+    public:
+
+        bool setup(std::string directory, size_t memory_cap);
+        void update(ofVec3f cam_position, ofVec3f look_dir, ofVec3f velocity, float fov);
+        void draw();
+        void stop();
+
+        bool is_enabled();
+        TileStreamerStats get_stats();
+
+        int uploads_per_frame;
+        float prefetch_time; // seconds of camera movement to look ahead
+        int lod_bias; // zoom levels coarser than the camera needs (set by the QualityGovernor)
+
+    private:
+
+        typedef vv_tile_pyramid::TileKey TileKey;
+
+        struct Tile {
+            shared_ptr <QuantizedGeometry> geometry;
+            uint64_t last_used; // frame number
+            size_t bytes;
+        };
+
+        struct LoadedTile {
+            TileKey key;
+            shared_ptr <QuantizedGeometry> geometry; // not uploaded yet
+        };
+
+        void threadedFunction();
+        shared_ptr <QuantizedGeometry> load_tile(TileKey key); // NULL for an empty or missing tile
+        void add_tiles_around(ofVec2f center, float radius, int z, std::set<TileKey> & tiles);
+        void evict();
+
+        bool _enabled;
+        std::string _directory;
+        ofRectangle _bounds;
+        int _max_zoom;
+        size_t _memory_cap;
+
+        // main thread only
+        std::map <TileKey, Tile> _resident;
+        std::set <TileKey> _requested;
+        vector <TileKey> _in_view;
+        TileStreamerStats _stats;
+
+        // shared with the loader thread, guarded by ofThread::mutex
+        deque <TileKey> _requests;
+        deque <LoadedTile> _loaded;
+        std::condition_variable _condition;
+};
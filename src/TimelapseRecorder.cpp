@@ -0,0 +1,314 @@
+#include "TimelapseRecorder.h"
+#include <cstring>
+
+//--------------------------------------------------------------
+TimelapseRecorder::TimelapseRecorder(){
+    background = ofColor(255);
+    frame_rate = 30;
+    _width = _height = 0;
+    _interval = 1;
+    _max_queued = 0;
+    _format = Y4M;
+    _recording = false;
+    _next_readback = 0;
+    _num_frames = 0;
+    _num_captured = 0;
+    _stats = TimelapseStats();
+    for (int r = 0; r < NUM_READBACKS; r++){
+        _readback_pixels[r] = NULL;
+        _readback_index[r] = -1;
+    }
+}
+
+//--------------------------------------------------------------
+TimelapseRecorder::~TimelapseRecorder(){
+    if (isThreadRunning()) stop();
+}
+
+//--------------------------------------------------------------
+// @args:   directory: where the videos go, relative to bin/data
+//          width, height: of the fbo that will be captured
+//          interval: a frame every interval rendered ones
+//          max_queued: frames between the fbo and the disk, the ones being
+//          read back included (at least NUM_READBACKS + 1). Each one takes
+//          width * height * 4 bytes, from the first begin() on.
+//--------------------------------------------------------------
+void TimelapseRecorder::setup(std::string directory, int width, int height, int interval, Format format, int max_queued){
+
+    _directory = directory;
+    _width = width;
+    _height = height;
+    _interval = std::max(1, interval);
+    _format = format;
+    _max_queued = std::max(NUM_READBACKS + 1, max_queued);
+
+    ofDirectory::createDirectory(_directory, true, true);
+
+    // written by glReadPixels, read by us
+    for (int r = 0; r < NUM_READBACKS; r++){
+        _readbacks[r].allocate(_width * _height * 4, GL_STREAM_READ);
+    }
+
+    startThread();
+}
+
+//--------------------------------------------------------------
+void TimelapseRecorder::begin(std::string name){
+
+    if (_recording) end();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (_pixels.empty()){
+        for (int p = 0; p < _max_queued; p++){
+            _pixels.push_back(std::unique_ptr<ofPixels>(new ofPixels()));
+            _pixels.back()->allocate(_width, _height, OF_IMAGE_COLOR_ALPHA);
+            _free_pixels.push_back(_pixels.back().get());
+        }
+        vv_memory::set(vv_memory::TIMELAPSE, _max_queued * _width * _height * 4);
+    }
+
+    _name = name;
+    _recording = true;
+    _num_frames = 0;
+    _num_captured = 0;
+    _stats.captured = 0;
+    _stats.dropped = 0;
+    _stats.written = 0;
+    _stats.bytes_written = 0;
+}
+
+//--------------------------------------------------------------
+// @desc:   takes the pixels out of the readbacks still in flight (they're a
+//          few frames old, the wait is short) and queues the end of the video
+//--------------------------------------------------------------
+void TimelapseRecorder::end(){
+
+    if (!_recording) return;
+
+    for (int r = 0; r < NUM_READBACKS; r++){
+        read_back((_next_readback + r) % NUM_READBACKS);
+    }
+
+    Frame frame;
+    frame.name = _name;
+    frame.index = _num_captured;
+    frame.close = true;
+    frame.pixels = NULL;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    _queue.push_back(frame);
+    _recording = false;
+    _condition.notify_one();
+}
+
+//--------------------------------------------------------------
+// @desc:   once every interval frames: queues the pixels read back
+//          NUM_READBACKS captures ago and starts reading the fbo into
+//          the same buffer, unless every pixel buffer is taken
+//--------------------------------------------------------------
+void TimelapseRecorder::capture(ofFbo & fbo){
+
+    if (!_recording) return;
+    if (_num_frames++ % _interval != 0) return;
+
+    int slot = _next_readback;
+    _next_readback = (_next_readback + 1) % NUM_READBACKS;
+    read_back(slot);
+
+    ofPixels * pixels = NULL;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (_free_pixels.empty()){
+            _stats.dropped++;
+            return;
+        }
+        pixels = _free_pixels.back();
+        _free_pixels.pop_back();
+        _stats.captured++;
+    }
+
+    // resolve the multisampled fbo and read from the resolved one (see TileAutosave)
+    fbo.updateTexture(0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.getIdDrawBuffer());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // into the pixel buffer: the call returns before the pixels are there
+    _readbacks[slot].bind(GL_PIXEL_PACK_BUFFER);
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    _readbacks[slot].unbind(GL_PIXEL_PACK_BUFFER);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    _readback_pixels[slot] = pixels;
+    _readback_index[slot] = _num_captured++;
+}
+
+//--------------------------------------------------------------
+void TimelapseRecorder::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopThread();
+        _condition.notify_all();
+    }
+    // the queue gets flushed before the thread exits
+    waitForThread(false);
+}
+
+//--------------------------------------------------------------
+bool TimelapseRecorder::is_recording(){
+    return _recording;
+}
+
+//--------------------------------------------------------------
+TimelapseStats TimelapseRecorder::get_stats(){
+
+    std::unique_lock<std::mutex> lock(mutex);
+    TimelapseStats stats = _stats;
+    stats.queued = _pixels.size() - _free_pixels.size();
+    return stats;
+}
+
+//--------------------------------------------------------------
+// called on the render thread, with the gl context
+//--------------------------------------------------------------
+void TimelapseRecorder::read_back(int slot){
+
+    if (_readback_pixels[slot] == NULL) return;
+
+    Frame frame;
+    frame.name = _name;
+    frame.index = _readback_index[slot];
+    frame.close = false;
+    frame.pixels = _readback_pixels[slot];
+
+    _readbacks[slot].bind(GL_PIXEL_PACK_BUFFER);
+    unsigned char * data = _readbacks[slot].map<unsigned char>(GL_READ_ONLY);
+    if (data) memcpy(frame.pixels->getData(), data, _width * _height * 4);
+    _readbacks[slot].unmap();
+    _readbacks[slot].unbind(GL_PIXEL_PACK_BUFFER);
+
+    _readback_pixels[slot] = NULL;
+    _readback_index[slot] = -1;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (data){
+        _queue.push_back(frame);
+        _condition.notify_one();
+    }
+    else {
+        _free_pixels.push_back(frame.pixels);
+        _stats.dropped++;
+    }
+}
+
+//--------------------------------------------------------------
+void TimelapseRecorder::threadedFunction(){
+
+    while (true){
+
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (_queue.empty() && isThreadRunning()){
+                _condition.wait(lock);
+            }
+            if (_queue.empty()) break;
+
+            frame = _queue.front();
+            _queue.pop_front();
+        }
+
+        if (frame.close){
+            close_stream();
+            continue;
+        }
+
+        uint64_t start_time = ofGetElapsedTimeMicros();
+        if (frame.name != _stream_name) open_stream(frame.name);
+        uint64_t bytes = _format == Y4M ? write_y4m(*frame.pixels) : write_png(*frame.pixels, frame.index);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        _free_pixels.push_back(frame.pixels);
+        _stats.written++;
+        _stats.bytes_written += bytes;
+        _stats.last_write_ms = (ofGetElapsedTimeMicros() - start_time) / 1000.0f;
+    }
+
+    close_stream();
+}
+
+//--------------------------------------------------------------
+void TimelapseRecorder::open_stream(std::string name){
+
+    close_stream();
+    _stream_name = name;
+
+    if (_format == Y4M){
+        std::string path = ofToDataPath(_directory + "/" + name + ".y4m");
+        _y4m.open(path.c_str(), std::ios::binary);
+        if (!_y4m.is_open()){
+            ofLogError() << "TimelapseRecorder: couldn't open " << path;
+            return;
+        }
+        // full range bt.601, like the jpegs
+        _y4m << "YUV4MPEG2 W" << _width << " H" << _height << " F" << frame_rate << ":1 Ip A1:1 C444 XCOLORRANGE=FULL\n";
+    }
+    else {
+        ofDirectory::createDirectory(_directory + "/" + name, true, true);
+    }
+}
+
+//--------------------------------------------------------------
+void TimelapseRecorder::close_stream(){
+
+    if (_stream_name.empty()) return;
+
+    if (_y4m.is_open()) _y4m.close();
+    cout << "TimelapseRecorder: " << _stream_name << " done" << endl;
+    _stream_name = "";
+}
+
+//--------------------------------------------------------------
+// @desc:   the artwork over the background, as y, u and v planes
+// @return: the bytes written
+//--------------------------------------------------------------
+uint64_t TimelapseRecorder::write_y4m(const ofPixels & pixels){
+
+    if (!_y4m.is_open()) return 0;
+
+    int n = _width * _height;
+    _planes.resize(n * 3);
+    unsigned char * y_plane = &_planes[0];
+    unsigned char * u_plane = y_plane + n;
+    unsigned char * v_plane = u_plane + n;
+
+    const unsigned char * rgba = pixels.getData();
+    for (int i = 0; i < n; i++, rgba += 4){
+
+        int a = rgba[3];
+        int r = (rgba[0] * a + background.r * (255 - a)) / 255;
+        int g = (rgba[1] * a + background.g * (255 - a)) / 255;
+        int b = (rgba[2] * a + background.b * (255 - a)) / 255;
+
+        // jfif coefficients, in 16.16 fixed point
+        y_plane[i] = ofClamp((19595 * r + 38470 * g + 7471 * b + 32768) >> 16, 0, 255);
+        u_plane[i] = ofClamp(((-11059 * r - 21709 * g + 32768 * b + 32768) >> 16) + 128, 0, 255);
+        v_plane[i] = ofClamp(((32768 * r - 27439 * g - 5329 * b + 32768) >> 16) + 128, 0, 255);
+    }
+
+    _y4m << "FRAME\n";
+    _y4m.write((const char *) &_planes[0], _planes.size());
+    _y4m.flush();
+    return 6 + _planes.size();
+}
+
+//--------------------------------------------------------------
+uint64_t TimelapseRecorder::write_png(const ofPixels & pixels, int index){
+
+    char file_name[32];
+    sprintf(file_name, "/%06d.png", index);
+    std::string path = _directory + "/" + _stream_name + file_name;
+    ofSaveImage(pixels, path);
+    return ofFile(path).getSize();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_memory.h"
+
+//--------------------------------------------------------------
+// A time-lapse of the artwork growing, one frame every few rendered ones,
+// without ever making the render thread wait for the disk.
+// The fbo is read back into a pixel buffer object, which returns right
+// away; the pixels are taken out of it a few captures later, when the
+// transfer is long over, and queued for a background thread that writes
+// them as an uncompressed y4m video (or a sequence of png files).
+// Only a fixed number of frames can be on their way at once: when the
+// writer falls behind, new frames are dropped (and counted) instead of
+// piling up.
+//
+// @example:
+//
+// timelapse.setup("timelapse", WIDTH/2, HEIGHT, 30); // a frame every 30
+// timelapse.begin("artwork_" + current_date_time());
+// timelapse.capture(fbo); // every frame, after drawing into it
+// timelapse.end();
+//--------------------------------------------------------------
+
+struct TimelapseStats {
+    int captured; // read back from the fbo, since the last begin()
+    int dropped; // skipped because the writer was behind
+    int written;
+    int queued; // read back or waiting for the writer
+    uint64_t bytes_written;
+    float last_write_ms;
+};
+
+class TimelapseRecorder : public ofThread {
+
+    public:
+
+        enum Format {
+            Y4M, // a single uncompressed video file, 4:4:4, played by ffmpeg and vlc
+            PNG_SEQUENCE // a folder of lossless frames, much smaller but slower to write
+        };
+
+        TimelapseRecorder();
+        ~TimelapseRecorder();
+
+        void setup(std::string directory, int width, int height, int interval, Format format = Y4M, int max_queued = 6);
+        void begin(std::string name); // a new video, the previous one is ended
+        void end(); // the frames still on their way are written before the file is closed
+        void capture(ofFbo & fbo); // every frame, needs the gl context
+        void stop();
+
+        bool is_recording();
+        TimelapseStats get_stats();
+
+        ofColor background; // under the transparent pixels of the artwork, y4m only
+        int frame_rate; // of the y4m video
+
+    private:
+
+        static const int NUM_READBACKS = 3; // pixel buffers in flight, a readback is mapped this many captures later
+
+        struct Frame {
+            std::string name; // of the video
+            int index; // in the video
+            bool close; // no pixels, the end of the video
+            ofPixels * pixels;
+        };
+
+        void read_back(int slot); // takes the pixels out of a pixel buffer and queues them
+        void threadedFunction();
+        void open_stream(std::string name);
+        void close_stream();
+        uint64_t write_y4m(const ofPixels & pixels);
+        uint64_t write_png(const ofPixels & pixels, int index);
+
+        std::string _directory;
+        int _width, _height, _interval, _max_queued;
+        Format _format;
+
+        // render thread only
+        ofBufferObject _readbacks[NUM_READBACKS];
+        ofPixels * _readback_pixels[NUM_READBACKS]; // where each one goes, NULL if not in use
+        int _readback_index[NUM_READBACKS];
+        std::string _name;
+        bool _recording;
+        int _next_readback, _num_frames, _num_captured;
+
+        // shared with the writer thread, guarded by ofThread::mutex
+        // a frame takes pixels from _free_pixels when it's read back and gives them back once written,
+        // so there are never more than _max_queued of them around (the readbacks included)
+        deque <Frame> _queue;
+        vector <ofPixels *> _free_pixels;
+        vector <std::unique_ptr<ofPixels> > _pixels; // all of them, allocated at the first begin()
+        std::condition_variable _condition;
+        TimelapseStats _stats;
+
+        // writer thread only
+        std::string _stream_name;
+        ofstream _y4m;
+        vector <unsigned char> _planes; // y, u and v of a frame
+};
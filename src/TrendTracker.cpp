@@ -0,0 +1,175 @@
+#include "TrendTracker.h"
+
+// forward decay weights are rescaled before they reach 2^MAX_EXPONENT, far from the float limits
+static const double MAX_EXPONENT = 64;
+
+//--------------------------------------------------------------
+TrendTracker::TrendTracker(){
+    setup(4, 2048, 10, 300);
+}
+
+//--------------------------------------------------------------
+// @args:   depth: rows of the sketch, more rows make a wrong count less likely
+//          width: counters per row (rounded up to a power of two), more make it less wrong
+//          k: how many keys are kept by name
+//          half_life: seconds for a count to halve
+//--------------------------------------------------------------
+void TrendTracker::setup(int depth, int width, int k, float half_life){
+
+    _depth = std::max(1, depth);
+    _width = 1;
+    while (_width < width) _width *= 2;
+    _width_mask = _width - 1;
+    _k = std::max(1, k);
+    _half_life = half_life;
+
+    _counters.assign(_depth * _width, 0);
+    _top.clear();
+    _top.reserve(_k);
+    _reference_time = now();
+    _num_added = 0;
+}
+
+//--------------------------------------------------------------
+void TrendTracker::add(std::string key, float weight){
+    add(key, weight, now());
+}
+
+//--------------------------------------------------------------
+// @args:   time: in seconds, for replaying recorded streams (add(key) uses the elapsed time)
+//--------------------------------------------------------------
+void TrendTracker::add(std::string key, float weight, double time){
+
+    if (key.size() > MAX_KEY_LENGTH) key.resize(MAX_KEY_LENGTH);
+
+    if ((time - _reference_time) / _half_life > MAX_EXPONENT) rescale(time);
+    float forward_weight = weight * exp2((time - _reference_time) / _half_life);
+
+    // conservative update: only the counters below the new estimate grow
+    uint64_t h = hash(key);
+    uint32_t h1 = h, h2 = (h >> 32) | 1;
+    float count = estimate(h) + forward_weight;
+    for (int d = 0; d < _depth; d++){
+        float & counter = _counters[d * _width + ((h1 + d * h2) & _width_mask)];
+        counter = std::max(counter, count);
+    }
+
+    // the top k: already there, a free slot, or it beats the smallest
+    int smallest = -1;
+    for (int t = 0; t < _top.size(); t++){
+        if (_top[t].hash == h && _top[t].key == key){
+            _top[t].count = count;
+            _num_added++;
+            return;
+        }
+        if (smallest < 0 || _top[t].count < _top[smallest].count) smallest = t;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.hash = h;
+    entry.count = count;
+    if (_top.size() < _k) _top.push_back(entry);
+    else if (count > _top[smallest].count) _top[smallest] = entry;
+
+    _num_added++;
+}
+
+//--------------------------------------------------------------
+float TrendTracker::get_count(std::string key){
+    return get_count(key, now());
+}
+
+//--------------------------------------------------------------
+// @args:   time: the same clock given to add(), seconds
+//--------------------------------------------------------------
+float TrendTracker::get_count(std::string key, double time){
+
+    if (key.size() > MAX_KEY_LENGTH) key.resize(MAX_KEY_LENGTH);
+    return estimate(hash(key)) / exp2((time - _reference_time) / _half_life);
+}
+
+//--------------------------------------------------------------
+vector <TrendTracker::Trend> TrendTracker::get_top(){
+    return get_top(now());
+}
+
+//--------------------------------------------------------------
+// @args:   time: the same clock given to add(), seconds
+//--------------------------------------------------------------
+vector <TrendTracker::Trend> TrendTracker::get_top(double time){
+
+    float scale = 1 / exp2((time - _reference_time) / _half_life);
+
+    vector <Trend> top(_top.size());
+    for (int t = 0; t < _top.size(); t++){
+        top[t].key = _top[t].key;
+        top[t].count = _top[t].count * scale;
+    }
+    std::sort(top.begin(), top.end(), [](const Trend & a, const Trend & b){
+        return a.count > b.count;
+    });
+    return top;
+}
+
+//--------------------------------------------------------------
+void TrendTracker::clear(){
+    setup(_depth, _width, _k, _half_life);
+}
+
+//--------------------------------------------------------------
+size_t TrendTracker::get_bytes(){
+
+    size_t bytes = _counters.capacity() * sizeof(float) + _top.capacity() * sizeof(Entry);
+    for (int t = 0; t < _top.size(); t++) bytes += _top[t].key.capacity();
+    return bytes;
+}
+
+//--------------------------------------------------------------
+int TrendTracker::get_num_added(){
+    return _num_added;
+}
+
+//--------------------------------------------------------------
+// FNV-1a, the two halves give the counter of each row (see add())
+//--------------------------------------------------------------
+uint64_t TrendTracker::hash(const std::string & key){
+
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < key.size(); i++){
+        h ^= (unsigned char) key[i];
+        h *= 1099511628211ULL;
+    }
+    // FNV alone mixes the high bits poorly for short keys
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+//--------------------------------------------------------------
+float TrendTracker::estimate(uint64_t h){
+
+    uint32_t h1 = h, h2 = (h >> 32) | 1;
+    float count = _counters[(h1) & _width_mask];
+    for (int d = 1; d < _depth; d++){
+        count = std::min(count, _counters[d * _width + ((h1 + d * h2) & _width_mask)]);
+    }
+    return count;
+}
+
+//--------------------------------------------------------------
+// brings every count back to weights around 1, once in a long while
+//--------------------------------------------------------------
+void TrendTracker::rescale(double time){
+
+    float scale = 1 / exp2((time - _reference_time) / _half_life);
+    for (int c = 0; c < _counters.size(); c++) _counters[c] *= scale;
+    for (int t = 0; t < _top.size(); t++) _top[t].count *= scale;
+    _reference_time = time;
+}
+
+//--------------------------------------------------------------
+double TrendTracker::now(){
+    return ofGetElapsedTimeMicros() / 1000000.0;
+}
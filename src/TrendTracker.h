@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ofMain.h"
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// The keys (hashtags, cities) seen the most lately, in fixed memory
+// however many different ones come through the stream.
+// Counts go in a count-min sketch (depth rows of width counters, each key
+// adds to one counter per row, its count is the smallest of them) with
+// conservative updates, and only the top k keys are kept by name.
+// Counts fade with the given half life using forward decay: a key seen
+// at time t adds 2^(t / half_life) instead of 1, and everything is divided
+// by the same factor when read, so nothing has to be decayed as time goes
+// by (the counters are rescaled only when the weights get too big).
+// add() is O(depth + k), whatever the number of keys.
+//
+// @example:
+//
+// TrendTracker trends;
+// trends.setup(4, 2048, 10, 300); // top 10, counts halve in 5 minutes
+// trends.add("#processing");
+// vector <TrendTracker::Trend> top = trends.get_top();
+//--------------------------------------------------------------
+
+class TrendTracker {
+
+    public:
+
+        struct Trend {
+            std::string key;
+            float count; // decayed, an estimate that can only be too high
+        };
+
+        TrendTracker();
+
+        void setup(int depth, int width, int k, float half_life);
+        void add(std::string key, float weight = 1);
+        void add(std::string key, float weight, double time); // seconds, never going back
+        float get_count(std::string key); // estimated, decayed to now
+        float get_count(std::string key, double time); // decayed to time, the clock of add()
+        vector <Trend> get_top(); // the most counted first
+        vector <Trend> get_top(double time);
+        void clear();
+
+        size_t get_bytes();
+        int get_num_added();
+
+        static const int MAX_KEY_LENGTH = 64; // longer keys are cut
+
+    private:
+
+        struct Entry {
+            std::string key;
+            uint64_t hash;
+            float count; // forward decayed, like the counters
+        };
+
+        uint64_t hash(const std::string & key);
+        float estimate(uint64_t hash); // min over the rows, forward decayed
+        void rescale(double time);
+        double now();
+
+        int _depth, _width, _k;
+        uint32_t _width_mask;
+        float _half_life;
+        double _reference_time; // weights are 2^((time - _reference_time) / half_life)
+        vector <float> _counters; // depth rows of width
+        vector <Entry> _top; // at most k, unsorted
+        int _num_added;
+};
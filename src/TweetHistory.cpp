@@ -0,0 +1,328 @@
+#include "TweetHistory.h"
+
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//--------------------------------------------------------------
+TweetHistory::TweetHistory(){
+    _size = 0;
+    _spill_fd = -1;
+    _spill_size = 0;
+    _num_spilled = 0;
+}
+
+//--------------------------------------------------------------
+TweetHistory::~TweetHistory(){
+    clear();
+#ifndef TARGET_WIN32
+    if (_spill_fd >= 0) close(_spill_fd);
+#endif
+}
+
+//--------------------------------------------------------------
+// all the columns of a chunk, one after the other
+// (65536 rows take 1.25 MB, a multiple of the page size, which mmap needs)
+//--------------------------------------------------------------
+size_t TweetHistory::chunk_bytes(){
+    return CHUNK_SIZE * (sizeof(uint32_t) + 2 * sizeof(int16_t) + 2 * sizeof(float) + sizeof(uint32_t));
+}
+
+//--------------------------------------------------------------
+void TweetHistory::allocate_chunk(){
+
+    shared_ptr <Chunk> chunk = make_shared<Chunk>();
+    chunk->size = 0;
+    chunk->min_time = UINT32_MAX;
+    chunk->max_time = 0;
+    chunk->mapped = NULL;
+    chunk->mapped_bytes = 0;
+    chunk->hashtag_bytes = 0;
+    chunk->heap.resize(chunk_bytes());
+
+    char * base = &chunk->heap[0];
+    chunk->times = (uint32_t *) base;
+    chunk->cities = (int16_t *) (base + CHUNK_SIZE * 4);
+    chunk->nations = (int16_t *) (base + CHUNK_SIZE * 6);
+    chunk->lons = (float *) (base + CHUNK_SIZE * 8);
+    chunk->lats = (float *) (base + CHUNK_SIZE * 12);
+    chunk->hashtag_offsets = (uint32_t *) (base + CHUNK_SIZE * 16);
+
+    _chunks.push_back(chunk);
+}
+
+//--------------------------------------------------------------
+void TweetHistory::add(uint32_t time, std::string city, std::string nation, float lon, float lat, std::string hashtags){
+
+    if (_chunks.empty() || _chunks.back()->size == CHUNK_SIZE){
+        // the full one won't change anymore
+        if (!_chunks.empty() && _spill_fd >= 0) spill(*_chunks.back());
+        allocate_chunk();
+    }
+
+    // dictionaries
+    int city_id = city.empty() ? -1 : get_id(city, _city_ids, _city_names);
+    int nation_id = get_id(nation, _nation_ids, _nation_names);
+
+    Chunk & chunk = *_chunks.back();
+
+    // the hashtags live with the rows of their chunk, and go with them when spilled
+    if (hashtags.size() > MAX_HASHTAG_BYTES) hashtags.resize(MAX_HASHTAG_BYTES);
+    uint32_t hashtag_offset = chunk.hashtag_pool.size();
+    chunk.hashtag_pool.insert(chunk.hashtag_pool.end(), hashtags.begin(), hashtags.end());
+    chunk.hashtag_pool.push_back('\0');
+    chunk.hashtag_bytes = chunk.hashtag_pool.size();
+
+    int row = chunk.size;
+    chunk.times[row] = time;
+    chunk.cities[row] = city_id;
+    chunk.nations[row] = nation_id;
+    chunk.lons[row] = lon;
+    chunk.lats[row] = lat;
+    chunk.hashtag_offsets[row] = hashtag_offset;
+    chunk.min_time = std::min(chunk.min_time, time);
+    chunk.max_time = std::max(chunk.max_time, time);
+    chunk.size++;
+
+    _size++;
+}
+
+//--------------------------------------------------------------
+// @desc:   from now on every full chunk is written to the given file and read back through mmap,
+//          its heap copy is freed. The file is rewritten at every run, it's not meant to be kept.
+//--------------------------------------------------------------
+bool TweetHistory::set_spill_file(std::string path){
+
+#ifdef TARGET_WIN32
+    ofLogWarning("TweetHistory") << "spilling to disk is not supported on windows";
+    return false;
+#else
+    if (_spill_fd >= 0) return true;
+
+    _spill_fd = open(ofToDataPath(path).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_spill_fd < 0){
+        ofLogError("TweetHistory") << "couldn't open " << path << " for spilling";
+        return false;
+    }
+    _spill_size = 0;
+
+    // the chunks already full go too
+    for (int c = 0; c + 1 < _chunks.size(); c++){
+        if (_chunks[c]->mapped == NULL) spill(*_chunks[c]);
+    }
+    return true;
+#endif
+}
+
+//--------------------------------------------------------------
+// @desc:   the columns and then the hashtags of the chunk, padded to a
+//          multiple of the page size so the next one can be mapped too
+//--------------------------------------------------------------
+void TweetHistory::spill(Chunk & chunk){
+
+#ifndef TARGET_WIN32
+    size_t bytes = chunk_bytes();
+    if (pwrite(_spill_fd, &chunk.heap[0], bytes, _spill_size) != bytes ||
+        pwrite(_spill_fd, &chunk.hashtag_pool[0], chunk.hashtag_bytes, _spill_size + bytes) != chunk.hashtag_bytes){
+        ofLogError("TweetHistory") << "couldn't write a chunk to the spill file, keeping it in memory";
+        return;
+    }
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t mapped_bytes = (bytes + chunk.hashtag_bytes + page - 1) / page * page;
+    void * mapped = mmap(NULL, mapped_bytes, PROT_READ, MAP_SHARED, _spill_fd, _spill_size);
+    if (mapped == MAP_FAILED){
+        ofLogError("TweetHistory") << "couldn't map a chunk of the spill file, keeping it in memory";
+        return;
+    }
+    _spill_size += mapped_bytes;
+
+    char * base = (char *) mapped;
+    chunk.mapped = mapped;
+    chunk.mapped_bytes = mapped_bytes;
+    chunk.times = (uint32_t *) base;
+    chunk.cities = (int16_t *) (base + CHUNK_SIZE * 4);
+    chunk.nations = (int16_t *) (base + CHUNK_SIZE * 6);
+    chunk.lons = (float *) (base + CHUNK_SIZE * 8);
+    chunk.lats = (float *) (base + CHUNK_SIZE * 12);
+    chunk.hashtag_offsets = (uint32_t *) (base + CHUNK_SIZE * 16);
+    vector <char>().swap(chunk.heap);
+    vector <char>().swap(chunk.hashtag_pool);
+    _num_spilled++;
+#endif
+}
+
+//--------------------------------------------------------------
+const char * TweetHistory::get_hashtag_pool(const Chunk & chunk){
+    if (chunk.mapped) return (const char *) chunk.mapped + chunk_bytes();
+    return chunk.hashtag_pool.empty() ? "" : &chunk.hashtag_pool[0];
+}
+
+//--------------------------------------------------------------
+// @return: the id of name in the dictionary, added if it's the first time;
+//          once the dictionary is full every new name shares the "other" id
+//--------------------------------------------------------------
+int TweetHistory::get_id(std::string name, std::map<std::string, int> & ids, vector<std::string> & names){
+
+    std::map <std::string, int>::iterator it = ids.find(name);
+    if (it != ids.end()) return it->second;
+
+    // the names come from outside, they must not wrap the 16 bit columns
+    if (names.size() == MAX_NAMES - 1) names.push_back("other");
+    if (names.size() >= MAX_NAMES) return MAX_NAMES - 1;
+
+    int id = names.size();
+    ids[name] = id;
+    names.push_back(name);
+    return id;
+}
+
+//--------------------------------------------------------------
+void TweetHistory::clear(){
+
+#ifndef TARGET_WIN32
+    for (int c = 0; c < _chunks.size(); c++){
+        if (_chunks[c]->mapped) munmap(_chunks[c]->mapped, _chunks[c]->mapped_bytes);
+    }
+    if (_spill_fd >= 0 && ftruncate(_spill_fd, 0) != 0){
+        ofLogWarning("TweetHistory") << "couldn't truncate the spill file";
+    }
+#endif
+    _chunks.clear();
+    _size = 0;
+    _city_ids.clear();
+    _city_names.clear();
+    _nation_ids.clear();
+    _nation_names.clear();
+    _spill_size = 0;
+    _num_spilled = 0;
+}
+
+//--------------------------------------------------------------
+int TweetHistory::count_range(uint32_t from, uint32_t to){
+
+    int count = 0;
+
+    for (int c = 0; c < _chunks.size(); c++){
+
+        Chunk & chunk = *_chunks[c];
+        if (chunk.size == 0 || chunk.max_time < from || chunk.min_time >= to) continue;
+        // entirely inside, no need to look at the rows
+        if (chunk.min_time >= from && chunk.max_time < to){
+            count += chunk.size;
+            continue;
+        }
+
+        const uint32_t * times = chunk.times;
+        int n = chunk.size;
+        int inside = 0;
+        for (int i = 0; i < n; i++){
+            inside += (times[i] >= from) & (times[i] < to);
+        }
+        count += inside;
+    }
+    return count;
+}
+
+//--------------------------------------------------------------
+void TweetHistory::count_by_city(uint32_t from, uint32_t to, vector<int> & counts){
+
+    // slot 0 collects the unknown cities (-1)
+    vector <int> histogram(_city_names.size() + 1, 0);
+
+    for (int c = 0; c < _chunks.size(); c++){
+
+        Chunk & chunk = *_chunks[c];
+        if (chunk.size == 0 || chunk.max_time < from || chunk.min_time >= to) continue;
+
+        const uint32_t * times = chunk.times;
+        const int16_t * cities = chunk.cities;
+        int n = chunk.size;
+        for (int i = 0; i < n; i++){
+            histogram[cities[i] + 1] += (times[i] >= from) & (times[i] < to);
+        }
+    }
+
+    counts.assign(histogram.begin() + 1, histogram.end());
+}
+
+//--------------------------------------------------------------
+void TweetHistory::count_by_nation(uint32_t from, uint32_t to, vector<int> & counts){
+
+    counts.assign(_nation_names.size(), 0);
+
+    for (int c = 0; c < _chunks.size(); c++){
+
+        Chunk & chunk = *_chunks[c];
+        if (chunk.size == 0 || chunk.max_time < from || chunk.min_time >= to) continue;
+
+        const uint32_t * times = chunk.times;
+        const int16_t * nations = chunk.nations;
+        int n = chunk.size;
+        for (int i = 0; i < n; i++){
+            counts[nations[i]] += (times[i] >= from) & (times[i] < to);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void TweetHistory::scan(uint32_t from, uint32_t to, std::function<void(const TweetRow &)> callback){
+
+    TweetRow row;
+
+    for (int c = 0; c < _chunks.size(); c++){
+
+        Chunk & chunk = *_chunks[c];
+        if (chunk.size == 0 || chunk.max_time < from || chunk.min_time >= to) continue;
+
+        const char * hashtags = get_hashtag_pool(chunk);
+        for (int i = 0; i < chunk.size; i++){
+            if (chunk.times[i] < from || chunk.times[i] >= to) continue;
+            row.time = chunk.times[i];
+            row.city = chunk.cities[i] < 0 ? "" : _city_names[chunk.cities[i]];
+            row.nation = _nation_names[chunk.nations[i]];
+            row.lon = chunk.lons[i];
+            row.lat = chunk.lats[i];
+            row.hashtags = hashtags + chunk.hashtag_offsets[i];
+            callback(row);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+int TweetHistory::size(){
+    return _size;
+}
+
+//--------------------------------------------------------------
+int TweetHistory::get_num_chunks(){
+    return _chunks.size();
+}
+
+//--------------------------------------------------------------
+int TweetHistory::get_num_spilled_chunks(){
+    return _num_spilled;
+}
+
+//--------------------------------------------------------------
+std::string TweetHistory::get_city_name(int city_id){
+    if (city_id < 0 || city_id >= _city_names.size()) return "";
+    return _city_names[city_id];
+}
+
+//--------------------------------------------------------------
+std::string TweetHistory::get_nation_name(int nation_id){
+    if (nation_id < 0 || nation_id >= _nation_names.size()) return "";
+    return _nation_names[nation_id];
+}
+
+//--------------------------------------------------------------
+size_t TweetHistory::get_bytes(){
+    size_t bytes = 0;
+    for (int c = 0; c < _chunks.size(); c++){
+        bytes += sizeof(Chunk) + _chunks[c]->heap.capacity() + _chunks[c]->hashtag_pool.capacity();
+    }
+    return bytes;
+}
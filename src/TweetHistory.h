@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ofMain.h"
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// Every tweet received, append only, stored by columns in chunks of
+// CHUNK_SIZE rows: time, city, nation, lon/lat and the offset of its hashtags
+// in the string pool of the chunk. Cities and nations are kept as ids in
+// dictionaries of their names, so the rows stay valid when the map (and the
+// order of its cities) is reloaded.
+// Every chunk remembers its first and last time, so that a time range query
+// skips whole chunks and scans the others with branchless loops the
+// compiler can vectorize (a few ms for millions of tweets).
+// Full chunks can optionally be moved to a memory mapped file (see
+// set_spill_file()) with their hashtags, so that weeks of tweets don't stay
+// on the heap.
+//
+// @example:
+//
+// history.add(time(NULL), "Rome", "Italy", lon, lat, "#pizza");
+// int last_hour = history.count_range(time(NULL) - 3600, time(NULL) + 1);
+//--------------------------------------------------------------
+
+struct TweetRow {
+    uint32_t time; // seconds since the epoch
+    std::string city; // empty if unknown
+    std::string nation;
+    float lon, lat; // -1, -1 if the tweet had no coordinates
+    std::string hashtags;
+};
+
+class TweetHistory {
+
+    public:
+
+        TweetHistory();
+        ~TweetHistory();
+
+        void add(uint32_t time, std::string city, std::string nation, float lon, float lat, std::string hashtags); // city: empty if unknown
+        bool set_spill_file(std::string path); // full chunks go there from now on, false if it can't be opened
+        void clear();
+
+        // queries on [from, to)
+        int count_range(uint32_t from, uint32_t to);
+        void count_by_city(uint32_t from, uint32_t to, vector<int> & counts); // counts[city id], the unknown ones left out
+        void count_by_nation(uint32_t from, uint32_t to, vector<int> & counts); // counts[nation id]
+        void scan(uint32_t from, uint32_t to, std::function<void(const TweetRow &)> callback); // in order, for replays
+
+        int size();
+        int get_num_chunks();
+        int get_num_spilled_chunks();
+        std::string get_city_name(int city_id);
+        std::string get_nation_name(int nation_id);
+        size_t get_bytes(); // on the heap, the spilled chunks are not counted
+
+        static const int CHUNK_SIZE = 65536;
+        static const int MAX_HASHTAG_BYTES = 1024; // per tweet, longer ones are cut: a chunk pool stays under 4 GB
+        static const int MAX_NAMES = INT16_MAX; // per dictionary, the ids are stored in 16 bits: the last one is "other"
+
+    private:
+
+        struct Chunk {
+            int size;
+            uint32_t min_time, max_time;
+            // the columns, pointing inside either heap or the mapped file
+            uint32_t * times;
+            int16_t * cities;
+            int16_t * nations;
+            float * lons;
+            float * lats;
+            uint32_t * hashtag_offsets; // in the pool of the chunk
+            vector <char> heap; // empty once spilled
+            vector <char> hashtag_pool; // '\0' terminated strings, empty once spilled
+            size_t hashtag_bytes;
+            void * mapped; // the columns, then the hashtags
+            size_t mapped_bytes;
+        };
+
+        static size_t chunk_bytes();
+        void allocate_chunk();
+        void spill(Chunk & chunk);
+        static const char * get_hashtag_pool(const Chunk & chunk);
+        static int get_id(std::string name, std::map<std::string, int> & ids, vector<std::string> & names);
+
+        vector <shared_ptr<Chunk> > _chunks;
+        int _size;
+
+        // dictionaries
+        std::map <std::string, int> _city_ids;
+        vector <std::string> _city_names;
+        std::map <std::string, int> _nation_ids;
+        vector <std::string> _nation_names;
+
+        // spill file
+        int _spill_fd;
+        size_t _spill_size;
+        int _num_spilled;
+};
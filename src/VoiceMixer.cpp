@@ -0,0 +1,303 @@
+#include "VoiceMixer.h"
+#include <cstring>
+
+//--------------------------------------------------------------
+// minimal RIFF/WAVE reader: 8/16/24/32 bit pcm and 32 bit float, converted to 16 bit
+//--------------------------------------------------------------
+static bool load_wav(std::string path, vector<int16_t> & pcm, int & channels, int & sample_rate){
+
+    ofBuffer file = ofBufferFromFile(path, true);
+    const unsigned char * data = (const unsigned char *) file.getData();
+    size_t size = file.size();
+
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) return false;
+
+    int format = 0, bits = 0;
+    channels = 0;
+    sample_rate = 0;
+
+    size_t offset = 12;
+    while (offset + 8 <= size){
+
+        uint32_t chunk_size = data[offset + 4] | (data[offset + 5] << 8) | (data[offset + 6] << 16) | (data[offset + 7] << 24);
+        const unsigned char * chunk = data + offset + 8;
+        if (offset + 8 + chunk_size > size) chunk_size = size - offset - 8;
+
+        if (memcmp(data + offset, "fmt ", 4) == 0 && chunk_size >= 16){
+            format = chunk[0] | (chunk[1] << 8);
+            channels = chunk[2] | (chunk[3] << 8);
+            sample_rate = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | (chunk[7] << 24);
+            bits = chunk[14] | (chunk[15] << 8);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub format guid
+            if (format == 0xFFFE && chunk_size >= 26) format = chunk[24] | (chunk[25] << 8);
+        }
+        else if (memcmp(data + offset, "data", 4) == 0 && channels > 0){
+
+            int bytes_per_sample = bits / 8;
+            if (bytes_per_sample == 0) return false;
+            size_t num_samples = chunk_size / bytes_per_sample;
+            pcm.resize(num_samples);
+
+            for (size_t s = 0; s < num_samples; s++){
+                const unsigned char * sample = chunk + s * bytes_per_sample;
+                if (format == 3 && bits == 32){
+                    float value;
+                    memcpy(&value, sample, sizeof(value));
+                    pcm[s] = int16_t(ofClamp(value, -1, 1) * 32767);
+                }
+                else if (bits == 8) pcm[s] = int16_t((int(sample[0]) - 128) << 8);
+                else if (bits == 16) pcm[s] = int16_t(sample[0] | (sample[1] << 8));
+                else if (bits == 24) pcm[s] = int16_t(sample[1] | (sample[2] << 8));
+                else if (bits == 32) pcm[s] = int16_t(sample[2] | (sample[3] << 8));
+                else return false;
+            }
+            return format == 1 || format == 3;
+        }
+
+        // chunks are padded to an even size
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------
+VoiceMixer::VoiceMixer(){
+
+    num_triggered = 0;
+    num_rate_limited = 0;
+    num_stolen = 0;
+    num_queue_full = 0;
+
+    _frames_played = 0;
+    _queue_read = 0;
+    _queue_write = 0;
+    _num_active_voices = 0;
+
+    for (int v = 0; v < MAX_VOICES; v++){
+        _voices[v].bank = -1;
+        _voices[v].next_bank = -1;
+    }
+}
+
+//--------------------------------------------------------------
+// @return: the id of the bank, or -1 if the file couldn't be decoded
+//--------------------------------------------------------------
+int VoiceMixer::load_bank(std::string path, float volume){
+
+    Bank bank;
+    if (!load_wav(path, bank.pcm, bank.channels, bank.sample_rate)){
+        ofLogError("VoiceMixer") << "couldn't decode " << path;
+        return -1;
+    }
+    bank.num_frames = bank.pcm.size() / bank.channels;
+    bank.volume = volume;
+    // no limit by default
+    bank.rate = 0;
+    bank.burst = 0;
+    bank.tokens = 0;
+
+    _banks.push_back(bank);
+
+    cout << "VoiceMixer::load_bank: " << path << ", " << bank.num_frames / float(bank.sample_rate) << " s, ";
+    cout << bank.pcm.size() * sizeof(int16_t) / 1024 << " KB" << endl;
+
+    return _banks.size() - 1;
+}
+
+//--------------------------------------------------------------
+// at most burst triggers at once, refilled at triggers_per_second
+//--------------------------------------------------------------
+void VoiceMixer::set_rate_limit(int bank, float triggers_per_second, float burst){
+
+    if (bank < 0 || bank >= _banks.size()) return;
+
+    _banks[bank].rate = triggers_per_second;
+    _banks[bank].burst = burst;
+    _banks[bank].tokens = burst;
+}
+
+//--------------------------------------------------------------
+// @args:   bank: see load_bank()
+//          speed: playback speed, 1 is the original pitch
+//          offset_seconds: where to start inside the sample
+// @return: false if the queue is full (the trigger is dropped)
+//--------------------------------------------------------------
+bool VoiceMixer::trigger(int bank, float speed, float offset_seconds){
+
+    if (bank < 0 || bank >= _banks.size()) return false;
+
+    uint32_t write = _queue_write.load(std::memory_order_relaxed);
+    uint32_t read = _queue_read.load(std::memory_order_acquire);
+    if (write - read >= QUEUE_SIZE){
+        num_queue_full++;
+        return false;
+    }
+
+    Trigger & t = _queue[write & (QUEUE_SIZE - 1)];
+    t.bank = bank;
+    t.speed = speed;
+    t.offset_seconds = offset_seconds;
+
+    _queue_write.store(write + 1, std::memory_order_release);
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void VoiceMixer::audioOut(ofSoundBuffer & buffer){
+
+    int sample_rate = buffer.getSampleRate();
+    int out_channels = buffer.getNumChannels();
+    int num_frames = buffer.getNumFrames();
+    float seconds = num_frames / float(sample_rate);
+
+    // 1. refill the token buckets
+    for (int b = 0; b < _banks.size(); b++){
+        Bank & bank = _banks[b];
+        if (bank.rate > 0) bank.tokens = std::min(bank.burst, bank.tokens + bank.rate * seconds);
+    }
+
+    // 2. take the pending triggers
+    uint32_t read = _queue_read.load(std::memory_order_relaxed);
+    uint32_t write = _queue_write.load(std::memory_order_acquire);
+    for (; read != write; read++){
+
+        const Trigger & t = _queue[read & (QUEUE_SIZE - 1)];
+        Bank & bank = _banks[t.bank];
+
+        if (bank.rate > 0){
+            if (bank.tokens < 1){
+                num_rate_limited++;
+                continue;
+            }
+            bank.tokens -= 1;
+        }
+
+        start_voice(t, sample_rate);
+        num_triggered++;
+    }
+    _queue_read.store(read, std::memory_order_release);
+
+    // 3. mix
+    vector <float> & out = buffer.getBuffer();
+    std::fill(out.begin(), out.end(), 0.0f);
+
+    int active = 0;
+
+    for (int v = 0; v < MAX_VOICES; v++){
+
+        Voice & voice = _voices[v];
+        if (voice.bank < 0) continue;
+        active++;
+
+        const Bank & bank = _banks[voice.bank];
+        const float to_float = bank.volume / 32768.0f;
+
+        for (int f = 0; f < num_frames; f++){
+
+            int frame = int(voice.position);
+            if (frame + 1 >= bank.num_frames || voice.fade_out == 0){
+                // a stolen voice goes straight to what it was stolen for
+                if (voice.next_bank >= 0){
+                    voice.bank = voice.next_bank;
+                    voice.position = voice.next_position;
+                    voice.step = voice.next_step;
+                    voice.fade_in = FADE_FRAMES;
+                    voice.fade_out = -1;
+                    voice.next_bank = -1;
+                    voice.started = _frames_played + f;
+                }
+                else {
+                    voice.bank = -1;
+                }
+                break;
+            }
+
+            float gain = 1;
+            if (voice.fade_in > 0){
+                gain = 1.0f - voice.fade_in / float(FADE_FRAMES);
+                voice.fade_in--;
+            }
+            if (voice.fade_out > 0){
+                gain *= voice.fade_out / float(FADE_FRAMES);
+                voice.fade_out--;
+            }
+
+            // linear interpolation between the two closest frames
+            float fraction = voice.position - frame;
+            for (int c = 0; c < out_channels; c++){
+                int bank_channel = c % bank.channels;
+                float a = bank.pcm[frame * bank.channels + bank_channel];
+                float b = bank.pcm[(frame + 1) * bank.channels + bank_channel];
+                out[f * out_channels + c] += (a + (b - a) * fraction) * to_float * gain;
+            }
+
+            voice.position += voice.step;
+        }
+    }
+
+    _frames_played += num_frames;
+    _num_active_voices = active;
+}
+
+//--------------------------------------------------------------
+// audio thread: picks a free voice, or steals the oldest one
+// (preferring the ones of the same bank, so a busy language doesn't silence the others)
+//--------------------------------------------------------------
+void VoiceMixer::start_voice(const Trigger & trigger, int sample_rate){
+
+    const Bank & bank = _banks[trigger.bank];
+    double step = trigger.speed * bank.sample_rate / double(sample_rate);
+    double position = ofClamp(trigger.offset_seconds * bank.sample_rate, 0, std::max(0, bank.num_frames - 2));
+
+    int chosen = -1;
+    for (int v = 0; v < MAX_VOICES && chosen < 0; v++){
+        if (_voices[v].bank < 0) chosen = v;
+    }
+
+    if (chosen >= 0){
+        Voice & voice = _voices[chosen];
+        voice.bank = trigger.bank;
+        voice.position = position;
+        voice.step = step;
+        voice.started = _frames_played;
+        voice.fade_in = FADE_FRAMES;
+        voice.fade_out = -1;
+        voice.next_bank = -1;
+        return;
+    }
+
+    // all busy
+    int oldest_same_bank = -1, oldest = -1;
+    for (int v = 0; v < MAX_VOICES; v++){
+        if (_voices[v].fade_out >= 0) continue; // already being stolen
+        if (oldest < 0 || _voices[v].started < _voices[oldest].started) oldest = v;
+        if (_voices[v].bank == trigger.bank && (oldest_same_bank < 0 || _voices[v].started < _voices[oldest_same_bank].started)) oldest_same_bank = v;
+    }
+    chosen = oldest_same_bank >= 0 ? oldest_same_bank : oldest;
+    if (chosen < 0) return; // everything is fading out already, drop it
+
+    // fade out what's playing, then start the new sound on the same voice
+    Voice & voice = _voices[chosen];
+    voice.fade_out = FADE_FRAMES;
+    voice.next_bank = trigger.bank;
+    voice.next_position = position;
+    voice.next_step = step;
+    num_stolen++;
+}
+
+//--------------------------------------------------------------
+int VoiceMixer::get_num_active_voices(){
+    return _num_active_voices;
+}
+
+//--------------------------------------------------------------
+size_t VoiceMixer::get_bytes(){
+
+    size_t bytes = 0;
+    for (int b = 0; b < _banks.size(); b++){
+        bytes += _banks[b].pcm.capacity() * sizeof(int16_t);
+    }
+    return bytes;
+}
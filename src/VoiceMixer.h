@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// Small polyphonic sampler used for the tweet sounds.
+// Each bank is a wav file decoded once to 16 bit pcm and kept in memory.
+// trigger() only pushes an event in a lock-free single producer/single consumer
+// queue; everything else happens on the audio thread inside audioOut():
+// a per bank rate limiter (token bucket), the allocation of one of the
+// MAX_VOICES voices (stealing the oldest when they're all busy) and the mix.
+//
+// @example:
+//
+// void ofApp::setup(){
+//     int bank = mixer.load_bank("sounds/chatting_en.wav", 0.5f);
+//     sound_stream.setOutput(&mixer);
+//     sound_stream.setup(2, 0, 44100, 512, 4);
+// }
+//
+// void ofApp::update(){
+//     mixer.trigger(bank, 1.0f, 0);
+// }
+//--------------------------------------------------------------
+
+class VoiceMixer : public ofBaseSoundOutput {
+
+    public:
+
+        static const int MAX_VOICES = 16;
+        static const int QUEUE_SIZE = 256; // power of two
+        static const int FADE_FRAMES = 256; // fade in/out, avoids clicks when stealing
+
+        VoiceMixer();
+
+        // call these before starting the sound stream
+        int load_bank(std::string path, float volume);
+        void set_rate_limit(int bank, float triggers_per_second, float burst);
+
+        // main thread, lock-free
+        bool trigger(int bank, float speed, float offset_seconds);
+
+        // audio thread
+        void audioOut(ofSoundBuffer & buffer);
+
+        int get_num_active_voices();
+        size_t get_bytes(); // pcm held in memory
+
+        // stats, since the start
+        std::atomic<int> num_triggered, num_rate_limited, num_stolen, num_queue_full;
+
+    private:
+
+        struct Bank {
+            vector <int16_t> pcm; // interleaved
+            int channels;
+            int sample_rate;
+            int num_frames;
+            float volume;
+            // token bucket, only touched by the audio thread after setup
+            float tokens, rate, burst;
+        };
+
+        struct Voice {
+            int bank; // -1 when free
+            double position; // in frames of the bank
+            double step; // frames of the bank per output frame
+            uint64_t started; // output frame, used to pick what to steal
+            int fade_in; // frames left
+            int fade_out; // frames left, -1 if not fading out
+            // what to play once the fade out of a stolen voice is over
+            int next_bank;
+            double next_position, next_step;
+        };
+
+        struct Trigger {
+            int bank;
+            float speed;
+            float offset_seconds;
+        };
+
+        void start_voice(const Trigger & trigger, int sample_rate);
+
+        vector <Bank> _banks;
+        Voice _voices[MAX_VOICES];
+        uint64_t _frames_played;
+
+        // single producer single consumer queue
+        Trigger _queue[QUEUE_SIZE];
+        std::atomic<uint32_t> _queue_read, _queue_write;
+
+        std::atomic<int> _num_active_voices;
+};
@@ -0,0 +1,251 @@
+#include "WalkerSwarm.h"
+
+//--------------------------------------------------------------
+// cheap per walker random numbers: a 32 bit LCG mapped to [0, 1)
+//--------------------------------------------------------------
+static inline float next_random(uint32_t & seed){
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+//--------------------------------------------------------------
+WalkerSwarm::WalkerSwarm(){
+    _scheduler = NULL;
+}
+
+//--------------------------------------------------------------
+// @args:   max_walkers: hard cap on the number of concurrent walkers
+//          dots_per_step: how many dots each walker leaves on the canvas every frame
+//          max_alpha: max alpha of each dot
+//--------------------------------------------------------------
+void WalkerSwarm::setup(int max_walkers, int dots_per_step, float max_alpha){
+
+    _max_walkers = max_walkers;
+    _dots_per_step = dots_per_step;
+    _max_alpha = max_alpha;
+
+    _pos_x.reserve(max_walkers);
+    _pos_y.reserve(max_walkers);
+    _vel_x.reserve(max_walkers);
+    _vel_y.reserve(max_walkers);
+    _target_x.reserve(max_walkers);
+    _target_y.reserve(max_walkers);
+    _age.reserve(max_walkers);
+    _seed.reserve(max_walkers);
+
+    _splats.setMode(OF_PRIMITIVE_POINTS);
+    _splats.setUsage(GL_STREAM_DRAW);
+
+    clear();
+}
+
+//--------------------------------------------------------------
+void WalkerSwarm::spawn(ofVec2f start, ofVec2f target){
+
+    if (_pos_x.size() < _max_walkers){
+        _pos_x.push_back(start.x);
+        _pos_y.push_back(start.y);
+        _vel_x.push_back(0);
+        _vel_y.push_back(0);
+        _target_x.push_back(target.x);
+        _target_y.push_back(target.y);
+        _age.push_back(0);
+        _seed.push_back(uint32_t(ofRandom(1, 2147483647.0f)));
+    }
+    // when full, the oldest walker gets the new target instead: retiring
+    // swaps walkers around, so the age is the only thing that tells
+    else {
+        int oldest = 0;
+        for (int i = 1; i < _age.size(); i++){
+            if (_age[i] > _age[oldest]) oldest = i;
+        }
+        _target_x[oldest] = target.x;
+        _target_y[oldest] = target.y;
+        _age[oldest] = 0;
+    }
+}
+
+//--------------------------------------------------------------
+void WalkerSwarm::update(float stdev){
+
+    uint64_t start_time = ofGetElapsedTimeMicros();
+
+    // retire old walkers by swapping them with the last one
+    for (int i = 0; i < _pos_x.size(); i++){
+        if (_age[i] > LIFESPAN){
+            int last = _pos_x.size() - 1;
+            _pos_x[i] = _pos_x[last]; _pos_x.pop_back();
+            _pos_y[i] = _pos_y[last]; _pos_y.pop_back();
+            _vel_x[i] = _vel_x[last]; _vel_x.pop_back();
+            _vel_y[i] = _vel_y[last]; _vel_y.pop_back();
+            _target_x[i] = _target_x[last]; _target_x.pop_back();
+            _target_y[i] = _target_y[last]; _target_y.pop_back();
+            _age[i] = _age[last]; _age.pop_back();
+            _seed[i] = _seed[last]; _seed.pop_back();
+            i--;
+        }
+    }
+
+    int n = _pos_x.size();
+
+    // every walker writes its dots in its own slice of the mesh
+    // the mesh accessors flag it as changed, so they're only called here
+    // and the batches get the raw pointers
+    vector <ofVec3f> & vertices = _splats.getVertices();
+    vector <ofFloatColor> & colors = _splats.getColors();
+    vertices.resize(n * _dots_per_step);
+    colors.resize(n * _dots_per_step);
+
+    if (n == 0){
+        return;
+    }
+
+    ofVec3f * vertex_data = &vertices[0];
+    ofFloatColor * color_data = &colors[0];
+
+    if (n <= BATCH_SIZE || _scheduler == NULL){
+        step_batch(0, n, stdev, vertex_data, color_data);
+    }
+    else {
+        // the pool is already there, no threads started every frame
+        _scheduler->parallel_for(0, n, BATCH_SIZE, [this, stdev, vertex_data, color_data](int from, int to){
+            step_batch(from, to, stdev, vertex_data, color_data);
+        });
+    }
+
+    // steps per second, averaged over one second windows
+    _steps_in_window += n;
+    _micros_in_window += ofGetElapsedTimeMicros() - start_time;
+    if (_micros_in_window > 1000000){
+        _steps_per_second = _steps_in_window * 1000000.0f / _micros_in_window;
+        _steps_in_window = 0;
+        _micros_in_window = 0;
+    }
+}
+
+//--------------------------------------------------------------
+// steps the walkers in [from, to) and splats their trails.
+// Same physics as the single SandLine attractor: unit attraction plus some jitter,
+// velocity limited to 8 pixels per frame.
+// @args:   vertices, colors: of the splats mesh, the dots of walker i go at i * dots_per_step
+//--------------------------------------------------------------
+void WalkerSwarm::step_batch(int from, int to, float stdev, ofVec3f * vertices, ofFloatColor * colors){
+
+    float * __restrict px = &_pos_x[0];
+    float * __restrict py = &_pos_y[0];
+    float * __restrict vx = &_vel_x[0];
+    float * __restrict vy = &_vel_y[0];
+    const float * __restrict tx = &_target_x[0];
+    const float * __restrict ty = &_target_y[0];
+    int * __restrict age = &_age[0];
+    uint32_t * __restrict seed = &_seed[0];
+
+    const float mass = 0.5f;
+    const float max_speed = 8.0f;
+
+    for (int i = from; i < to; i++){
+
+        float dx = tx[i] - px[i];
+        float dy = ty[i] - py[i];
+        float inv_len = 1.0f / std::sqrt(dx * dx + dy * dy + 1e-6f);
+
+        float fx = dx * inv_len + (next_random(seed[i]) * 1.5f - 0.75f);
+        float fy = dy * inv_len + (next_random(seed[i]) * 1.5f - 0.75f);
+
+        float nvx = vx[i] + fx * mass;
+        float nvy = vy[i] + fy * mass;
+
+        // limit the speed without branching
+        float speed = std::sqrt(nvx * nvx + nvy * nvy);
+        float limit = std::min(1.0f, max_speed / (speed + 1e-6f));
+        nvx *= limit;
+        nvy *= limit;
+
+        vx[i] = nvx;
+        vy[i] = nvy;
+        px[i] += nvx;
+        py[i] += nvy;
+        age[i]++;
+    }
+
+    // those trail of points have a gaussian distribution around the current position,
+    // approximated by the sum of three uniform numbers
+    const int max_offset = 32;
+    const float spread = stdev * max_offset * 2.0f;
+
+    for (int i = from; i < to; i++){
+        for (int d = 0; d < _dots_per_step; d++){
+
+            float gx = next_random(seed[i]) + next_random(seed[i]) + next_random(seed[i]) - 1.5f;
+            float gy = next_random(seed[i]) + next_random(seed[i]) + next_random(seed[i]) - 1.5f;
+            float alpha = next_random(seed[i]) * _max_alpha / 255.0f;
+
+            int v = i * _dots_per_step + d;
+            vertices[v].x = px[i] + gx * spread;
+            vertices[v].y = py[i] + gy * spread;
+            vertices[v].z = 0;
+            colors[v] = ofFloatColor(0, 0, 0, alpha);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+// call this inside the fbo begin/end
+//--------------------------------------------------------------
+void WalkerSwarm::draw(){
+
+    if (_pos_x.empty()) return;
+
+    // ofApp sets a bigger point size for the fireworks sprites
+    GLfloat previous_point_size;
+    glGetFloatv(GL_POINT_SIZE, &previous_point_size);
+    glPointSize(1);
+
+    _splats.draw();
+
+    glPointSize(previous_point_size);
+}
+
+//--------------------------------------------------------------
+void WalkerSwarm::clear(){
+
+    _pos_x.clear();
+    _pos_y.clear();
+    _vel_x.clear();
+    _vel_y.clear();
+    _target_x.clear();
+    _target_y.clear();
+    _age.clear();
+    _seed.clear();
+    _splats.clear();
+    _splats.setMode(OF_PRIMITIVE_POINTS);
+
+    _steps_in_window = 0;
+    _micros_in_window = 0;
+    _steps_per_second = 0;
+}
+
+//--------------------------------------------------------------
+void WalkerSwarm::set_scheduler(TaskScheduler * scheduler){
+    _scheduler = scheduler;
+}
+
+//--------------------------------------------------------------
+int WalkerSwarm::size(){
+    return _pos_x.size();
+}
+
+//--------------------------------------------------------------
+const float * WalkerSwarm::get_xs(){
+    return _pos_x.empty() ? NULL : &_pos_x[0];
+}
+
+//--------------------------------------------------------------
+const float * WalkerSwarm::get_ys(){
+    return _pos_y.empty() ? NULL : &_pos_y[0];
+}
+
+//--------------------------------------------------------------
+float WalkerSwarm::get_steps_per_second(){
+    return _steps_per_second;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ofMain.h"
+#include "TaskScheduler.h"
+#include <stdint.h>
+
+//--------------------------------------------------------------
+// Many attractor walkers at once, the multi agent version of SandLine's ATTRACTOR_MODE.
+// Every walker chases its own target and leaves a gaussian trail of dots behind.
+// Walkers are stored as structure of arrays so that the stepping loops are plain
+// float loops the compiler can vectorize, and they are split in batches
+// that run on the workers of a TaskScheduler when there are enough of them.
+// All the trails of a frame are splatted with a single draw call.
+//--------------------------------------------------------------
+
+class WalkerSwarm {
+
+    public:
+
+        WalkerSwarm();
+
+        void setup(int max_walkers, int dots_per_step, float max_alpha);
+        void set_scheduler(TaskScheduler * scheduler); // NULL steps all the batches on the calling thread
+        void spawn(ofVec2f start, ofVec2f target); // spawns, or retargets the oldest walker when full
+        void update(float stdev); // one simulation step for every walker
+        void draw();
+        void clear();
+
+        int size();
+        const float * get_xs();
+        const float * get_ys();
+        float get_steps_per_second();
+
+        // walkers retire after this many steps
+        static const int LIFESPAN = 270;
+        // below this number of walkers it's not worth going parallel
+        static const int BATCH_SIZE = 1024;
+
+    private:
+
+        void step_batch(int from, int to, float stdev, ofVec3f * vertices, ofFloatColor * colors);
+
+        int _max_walkers, _dots_per_step;
+        float _max_alpha;
+        TaskScheduler * _scheduler;
+
+        // structure of arrays, one entry per walker
+        vector <float> _pos_x, _pos_y;
+        vector <float> _vel_x, _vel_y;
+        vector <float> _target_x, _target_y;
+        vector <int> _age;
+        vector <uint32_t> _seed; // per walker random state, keeps the loops vectorizable
+
+        // trails
+        ofVboMesh _splats;
+
+        // stats
+        uint64_t _steps_in_window, _micros_in_window;
+        float _steps_per_second;
+};
@@ -1,9 +1,20 @@
 #include "ofMain.h"
 #include "ofApp.h"
 #include "globals.h"
+#include "vv_tile_pyramid.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char * argv[]){
+
+	// offline step: cut the map in a tile pyramid for TileStreamer and exit
+	// usage: bin/<app name> --build-tiles [file.geojson] [max_zoom]
+	if (argc > 1 && std::string(argv[1]) == "--build-tiles"){
+		std::string geojson_path = argc > 2 ? argv[2] : "world_cities_countries.geojson";
+		int max_zoom = argc > 3 ? ofToInt(argv[3]) : 5;
+		// same scale used in ofApp::setup()
+		return vv_tile_pyramid::build(geojson_path, "tiles", max_zoom, WIDTH / (2 * PI)) ? 0 : 1;
+	}
+
 	// ofSetupOpenGL(2560,1080,OF_WINDOW);			// <-------- setup the GL context
 
 	ofGLFWWindowSettings settings;
@@ -4,6 +4,10 @@
 //--------------------------------------------------------------
 void ofApp::setup(){
 
+    // STARTUP TRACE
+    // nested spans saved to bin/data/startup_trace.json once all the assets are loaded (see vv_trace.h)
+    vv_trace::begin("setup");
+
     ofSetVerticalSync(true);
 	ofSetFrameRate(45);
 
@@ -14,13 +18,80 @@ void ofApp::setup(){
     arduino_digital_events_counter = 0;
 
     // FBO FOR THE 3D ENVIRONMENT 
-    threed_map_fbo.allocate(WIDTH/2, HEIGHT, GL_RGBA, 8);
+    vv_trace::begin("fbo allocation");
+    threed_map_samples = 8;
+    threed_map_fbo.allocate(WIDTH/2, HEIGHT, GL_RGBA, threed_map_samples);
     // CANVAS FOR THE GENERATIVE ARTWORK
     sand_line.setup(WIDTH/2, HEIGHT, 1, 35);
+    vv_trace::end();
+
+    // PROFILING
+    // 'p' toggles the overlay, 'c' saves the last frames to csv
+    phase_tweets = profiler.add_phase("tweets");
+    phase_sand_line = profiler.add_phase("sand_line");
+    phase_camera = profiler.add_phase("camera");
+    phase_density = profiler.add_phase("density");
+    phase_hashtags = profiler.add_phase("hashtags");
+    phase_reproject = profiler.add_phase("reproject");
+    phase_history = profiler.add_phase("history");
+    phase_map_draw = profiler.add_phase("map_draw");
+    phase_labels = profiler.add_phase("labels");
+    phase_text_draw = profiler.add_phase("text_draw");
+    phase_composite = profiler.add_phase("composite");
+    // osc, fireworks and the camera physics run on the simulation thread, each tick is one of its frames
+    phase_sim_osc = sim_profiler.add_phase("sim_osc");
+    phase_sim_tweets = sim_profiler.add_phase("sim_tweets");
+    phase_sim_fireworks = sim_profiler.add_phase("sim_fireworks");
+    phase_sim_camera = sim_profiler.add_phase("sim_camera");
+
+    // TASKS
+    // a worker per core but one, this thread helps while waiting (see TaskScheduler)
+    scheduler.start();
+    sand_line.swarm.set_scheduler(&scheduler);
+    tasks_serial_ms = 0;
+    tasks_wall_ms = 0;
+    tasks_overhead_ms = 0;
+    tasks_frames = 0;
+    last_tasks_view_time = 0;
+
+    // AUTOSAVE
+    // only the tiles of the canvas touched since the last checkpoint get written
+    autosave_interval = 30;
+    last_autosave_time = 0;
+    autosave.setup("autosave", WIDTH/2, HEIGHT, SandLine::TILE_SIZE);
+
+    // QUALITY
+    // every change of level goes in bin/data/quality_log.csv
+    max_fireworks = 16;
+    frame_start_time = ofGetElapsedTimeMicros();
+    governor.setup(45, "quality_log.csv");
+    apply_quality();
+
+    // METRICS
+    // http://127.0.0.1:9145/metrics, and bin/data/metrics.prom every 10 seconds
+    metrics_server.setup(9145, "metrics.prom");
+
+    // TIME-LAPSE
+    // a frame every second or so, a visit of a few minutes is a few seconds of video
+    timelapse_enabled = false;
+    timelapse.setup("timelapse", WIDTH/2, HEIGHT, 30);
 
     // TYPE
+    vv_trace::begin("font load");
     font.load("fonts/AndaleMono.ttf", 15, true, true, true, 1.0f);
+    vv_trace::end();
+    vv_trace::begin("legend font load");
     legend_font.load("fonts/AndaleMono.ttf", 8, true, true, true, 1.0f);
+    vv_trace::end();
+
+    std::stringstream description;
+    description << "Welcome.\n\n";
+    description << "On the right side of the screen you will see a drawing generated\n";
+    description << "from a real time stream of people tweeting stuff about different cities.\n\n";
+    description << "On the left side, you have the chance explore a map of those tweets\n";
+    description << "using the joystick and the buttons.\n\n";
+    description << "When you're ready, press the joystick to start.";
+    intro_text = description.str();
 
     // ARDUINO
     joystick_pressed = false;
@@ -33,11 +104,24 @@ void ofApp::setup(){
     current_tweet_hashtags = "";
     osc_receiver.setup(9000);
 
+    // HISTORY
+    // full chunks of tweets are moved to a memory mapped file, the heap only keeps the last one
+    tweet_history.set_spill_file("tweet_history.bin");
+    last_history_view_time = 0;
+
+    // TRENDS
+    // what's been tweeted the most in the last minutes, counts halve every 10 minutes
+    trending_hashtags.setup(4, 4096, 10, 600);
+    trending_cities.setup(4, 1024, 5, 600);
+    vv_memory::set(vv_memory::TRENDS, trending_hashtags.get_bytes() + trending_cities.get_bytes());
+
     // 3D
     text_scale = 0.2f;
     // don't use the normal gl texture
 	ofDisableArbTex();
+    vv_trace::begin("firework texture");
     ofLoadImage(firework_texture, "dot.png");
+    vv_trace::end();
     glPointSize(5);
 
     // CAMERA
@@ -55,53 +139,200 @@ void ofApp::setup(){
     cam_orientation = ofVec3f(26, 0, 0);
     cam_orient_velocity = ofVec3f(0, 0, 0);
     cam_orient_acceleration = ofVec3f(0, 0, 0);
+    // what's drawn until the simulation publishes its first snapshot
+    view_state.cam_position = cam_position;
+    view_state.cam_orientation = get_cam_quaternion();
+    num_fireworks_created = 0;
 
     // SOUND
-    // load samples for background noise
-    chatting_sound_en.load("sounds/chatting_en.wav");
-    chatting_sound_jp.load("sounds/chatting_jp.wav");
-    chatting_sound_es.load("sounds/chatting_es.wav");
-    chatting_sound_fr.load("sounds/chatting_fr.wav");
-    chatting_sound_de.load("sounds/chatting_de.wav");
-    chatting_sound_gr.load("sounds/chatting_gr.wav");
-    chatting_sound_it.load("sounds/chatting_it.wav");
-    thanks_sound.load("sounds/thanks.wav");
-    // set volumes
-    chatting_sound_en.setVolume(0.5f);
-    chatting_sound_jp.setVolume(0.5f);
-    chatting_sound_es.setVolume(0.5f);
-    chatting_sound_fr.setVolume(0.5f);
-    chatting_sound_de.setVolume(0.5f);
-    chatting_sound_it.setVolume(0.5f);
-    chatting_sound_gr.setVolume(0.5f);
+    // load samples for background noise, decoded once to pcm on a loader thread.
+    // the stream starts only when all the banks are there, the audio thread never sees them change
+    vv_trace::begin("queue assets");
+    assets.add_job("sounds", [this](){
+        auto load_sound = [this](std::string path, float volume){
+            vv_trace::Span span("load " + path);
+            return mixer.load_bank(path, volume);
+        };
+        chatting_sound_en = load_sound("sounds/chatting_en.wav", 0.5f);
+        chatting_sound_jp = load_sound("sounds/chatting_jp.wav", 0.5f);
+        chatting_sound_es = load_sound("sounds/chatting_es.wav", 0.5f);
+        chatting_sound_fr = load_sound("sounds/chatting_fr.wav", 0.5f);
+        chatting_sound_de = load_sound("sounds/chatting_de.wav", 0.5f);
+        chatting_sound_gr = load_sound("sounds/chatting_gr.wav", 0.5f);
+        chatting_sound_it = load_sound("sounds/chatting_it.wav", 0.5f);
+        thanks_sound = load_sound("sounds/thanks.wav", 1.0f);
+        // during bursts of tweets each language plays at most 3 sounds at once, then 2 per second
+        int chatting_banks[] = {chatting_sound_en, chatting_sound_jp, chatting_sound_es, chatting_sound_fr, chatting_sound_de, chatting_sound_gr, chatting_sound_it};
+        for (int i = 0; i < 7; i++){
+            mixer.set_rate_limit(chatting_banks[i], 2, 3);
+        }
+        vv_memory::set(vv_memory::SOUND_BUFFERS, mixer.get_bytes());
+    },
+    [this](){
+        sound_stream.setOutput(&mixer);
+        sound_stream.setup(2, 0, 44100, 512, 4);
+    });
 
     // GEOJSON
-    geojson_scale = 400;
-    std::string file_path = "world_cities_countries.geojson";
+    // mercator() always used this, whatever scale it was given: keep the map as it was designed
+    geojson_scale = WIDTH / (2 * PI);
     // geoshape_bb = ofRectangle(ofPoint(-120, -36), 170, 80); // testing on the macbook air
     geoshape_bb = ofRectangle(ofPoint(-310, -120), 406, 184); // with the full res
 
-    // create the actual geojson meshes and return the centroid
-    ofPoint geoshape_centroid = vv_geojson::create_geojson_map(file_path, font, poly_meshes, cities, geojson_scale);
-    
-    // let the cam look at the centroid of the shape
-    cam.lookAt(geoshape_centroid);
+    // datasets too big for memory are cut in a tile pyramid offline (see main.cpp)
+    // and streamed in around the camera, with a 64 MB cap; the map then
+    // only keeps the cities and the countries, the outlines come from the tiles
+    map_tiles.setup("tiles", 64 * 1024 * 1024);
+    bool map_outlines = !map_tiles.is_enabled();
+
+    // parsing, extrusion and quantization happen on a loader thread,
+    // only the buffer uploads are left for the main thread, 1 MB at a time
+    map_path = "world_cities_countries.geojson";
+    map_data = std::make_shared<MapData>(); // empty until then
+    std::shared_ptr <MapData> loaded_map = std::make_shared<MapData>();
+    assets.add_sliced_job("map", [this, loaded_map, map_outlines](){
+        loaded_map->load(map_path, font, geojson_scale, WIDTH/2, HEIGHT, &scheduler, map_outlines);
+    },
+    [this, loaded_map, map_outlines](){
+        if (!loaded_map->upload_slice(projection_t, geojson_scale, 1024 * 1024)) return false;
+
+        // let the cam look at the centroid of the shape
+        cam.lookAt(loaded_map->centroid);
+        std::atomic_store(&map_data, loaded_map);
+
+        loaded_map->print_stats();
+        cout << "ended parsing of file" << endl;
+
+        // from now on, saving the file loads the map again in the background (see update())
+        // its memory counts as "map reload" until it's swapped in, the gauges still show the live map
+        map_reloader.setup(map_path, [this, map_outlines](std::string path){
+            std::shared_ptr <MapData> reloaded = std::make_shared<MapData>();
+            reloaded->memory = std::make_shared<vv_memory::Staging>(vv_memory::MAP_RELOAD);
+            reloaded->memory->begin();
+            bool loaded = reloaded->load(path, font, geojson_scale, WIDTH/2, HEIGHT, &scheduler, map_outlines);
+            reloaded->memory->end();
+            if (!loaded) reloaded.reset();
+            return reloaded;
+        });
+        return true;
+    });
+
+    // one thread each, the map is by far the slowest
+    assets.start(2);
+    vv_trace::end();
+
+    // PROJECTION
+    projection_t = 0;
+    projection_target = 0;
+
+    // DENSITY
+    // covers the whole mercator plane (up to ~85 degrees of latitude), tweets count half after a minute
+    vv_trace::begin("density allocation");
+    ofPoint mercator_corner = vv_map_projections::mercator(180, 85, geojson_scale);
+    tweet_density.setup(ofRectangle(-mercator_corner.x, -mercator_corner.y, mercator_corner.x * 2, mercator_corner.y * 2), 512, 512, 60);
+    vv_memory::set(vv_memory::DENSITY, tweet_density.get_bytes());
+    vv_trace::end();
+
+    // HASHTAGS
+    // extruded on a background thread, then uploaded at most 64 KB per frame
+    hashtags.setup(font, 0.025, 2);
+
+    // MEMORY
+    // 'm' prints the report, a summary line is logged every 10 minutes
+    memory_log_interval = 600;
+    last_memory_log_time = 0;
 
     // clean the buffer
     threed_map_fbo.begin();
     ofClear(255);
     threed_map_fbo.end();
 
-    cout << "overall centroid: " << geoshape_centroid << endl;
-    cout << "ended parsing of file" << endl;
-    cout << "poly_meshes.size(): " << poly_meshes.size() << endl;
-    cout << "cities.size(): " << cities.size() << endl;
+    // if we crashed during a session, pick up the artwork where it was left
+    vv_trace::begin("autosave restore");
+    if (autosave.restore(*sand_line.get_fbo_pointer())){
+        show_intro_screen = false;
+        final_greet = true;
+    }
+    vv_trace::end();
+
+    // SIMULATION
+    // 45 ticks per second, the frame rate the camera physics were tuned for
+    sim_loaded = false;
+    sim_active = false;
+    simulation.setup(45, [this](SimSnapshot & next, float dt){
+        simulate(next, dt);
+    });
+
+    vv_trace::end(); // setup
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
 
+    frame_start_time = ofGetElapsedTimeMicros();
+
     updateArduino();
+
+    vv_metrics::observe(vv_metrics::FRAME_MS, ofGetLastFrameTime() * 1000);
+    vv_metrics::set(vv_metrics::FPS, ofGetFrameRate());
+
+    // finish the assets loaded in the background, a few ms per frame
+    if (!assets.is_done()){
+        assets.update(4);
+        // the trace is for the startup: recording the rest of the run would only pile up spans
+        if (assets.is_done()){
+            vv_trace::save("startup_trace.json");
+            vv_trace::set_enabled(false);
+            vv_trace::clear();
+        }
+    }
+    bool loading = !assets.is_done();
+
+    // a new map, loaded in the background after the file changed:
+    // upload it 1 MB per frame and swap it in between two frames, the old one keeps drawing until then
+    // (a newer one replaces a map still uploading, it's not shared with anybody yet)
+    std::shared_ptr <MapData> reloaded = map_reloader.update();
+    if (reloaded){
+        pending_map = reloaded;
+        pending_map_frames = 0;
+        pending_map_max_ms = 0;
+    }
+    if (pending_map){
+        uint64_t slice_start = ofGetElapsedTimeMicros();
+        pending_map->memory->begin();
+        bool uploaded = pending_map->upload_slice(projection_t, geojson_scale, 1024 * 1024);
+        pending_map->memory->end();
+        if (uploaded){
+            retired_maps.push_back(map_data);
+            std::atomic_store(&map_data, pending_map);
+            pending_map->memory->commit();
+            pending_map->memory.reset();
+        }
+        pending_map_frames++;
+        pending_map_max_ms = std::max(pending_map_max_ms, (ofGetElapsedTimeMicros() - slice_start) / 1000.0f);
+
+        if (uploaded){
+            cout << current_date_time() << " map reloaded: " << pending_map->cities.size() << " cities, ";
+            cout << pending_map->country_fill.get_num_countries() << " countries, built in " << map_reloader.get_last_load_ms() << " ms in the background, ";
+            cout << "uploaded in " << pending_map_frames << " frames, at most " << pending_map_max_ms << " ms each" << endl;
+            pending_map.reset();
+        }
+    }
+    // gpu buffers can only be deleted here, the simulation might still hold an old map for a tick
+    for (int m = retired_maps.size() - 1; m >= 0; m--){
+        if (retired_maps[m].unique()) retired_maps.erase(retired_maps.begin() + m);
+    }
+    std::shared_ptr <MapData> map = map_data; // the one of this frame
+    map->labels.budget = governor.get_settings().label_budget; // a reloaded map starts at the default
+
+    // tweets need the cities, the camera and the fireworks move only on the map
+    sim_loaded = !loading;
+    sim_active = !show_intro_screen && !loading;
+
+    // nothing to start yet, forget the press
+    if (joystick_pressed && loading){
+        joystick_pressed = false;
+    }
     
     if (joystick_pressed){
         
@@ -111,19 +342,25 @@ void ofApp::update(){
 
             show_intro_screen = false;
             final_greet = true;
+            if (timelapse_enabled) timelapse.begin("artwork_" + current_date_time());
         }
         else {
 
             cout << "thank you" << endl;
             ofFbo * fbo = sand_line.get_fbo_pointer();
 
-            thanks_sound.play();
+            mixer.trigger(thanks_sound, 1.0f, 0);
                 
             // save artwork
             save_fbo(fbo, current_date_time() + ".png");
+            if (timelapse.is_recording()){
+                timelapse.end();
+                log_timelapse();
+            }
 
             // get ready to start again
             sand_line.reset();
+            autosave.clear_store();
             show_intro_screen = true;
             final_greet = false;
         }
@@ -131,157 +368,154 @@ void ofApp::update(){
         joystick_pressed = false;
     }
 
-    if (!show_intro_screen){
+    bool on_map = !show_intro_screen && !loading;
 
-        // update the artwork
-        sand_line.update();
+    // the camera first, the labels are placed from it
+    if (on_map){
+        ProfileScope scope(profiler, phase_camera);
 
-        // update the dataviz
-        for (Firework firework : fireworks){
-            firework.update();
-        }
+        // camera and fireworks, one tick behind the simulation
+        simulation.get_interpolated(view_state);
+        cam.setPosition(view_state.cam_position); // see compute_cam_movement()
+        cam.setOrientation(view_state.cam_orientation);
 
-        if (zoom_in_pressed) cam_zoom_in();
-        if (zoom_out_pressed) cam_zoom_out();
-        
-        // move and orient camera
-        compute_cam_movement();
-        compute_cam_orientation();
+        // stream in the map tiles around what we're looking at
+        // (the map is drawn translated by -geoshape_centroid)
+        map_tiles.update(view_state.cam_position + geoshape_centroid, cam.getLookAtDir(), view_state.cam_move_velocity, cam.getFov());
     }
 
-    
-    // check for osc messages
-	while (osc_receiver.hasWaitingMessages()){
-        ofxOscMessage m;
-        osc_receiver.getNextMessage(m);
-
-        // receive arduino stuff
-        if (m.getAddress() == "/arduino/digital"){
-            
-            int pin_num = m.getArgAsInt(0);
-            int value = m.getArgAsInt32(1);
-
-            // cout << "--------------------" << endl;
-            // cout << "/arduino/digital, " << pin_num << ", " << value << endl;
-
-            if (pin_num == 2){
-                joystick_pressed = !value;
+    // FRAME TASKS
+    // the phases below don't need each other unless stated: they go on the workers,
+    // except for the ones with gl calls that stay on this thread (see TaskScheduler)
+    float dt = ofGetLastFrameTime();
+    frame_graph.clear();
+    int sand_line_task = -1, density_task = -1, density_upload_task = -1, countries_task = -1, countries_upload_task = -1;
+    int reproject_task = -1, labels_task = -1, history_task = -1, hashtags_task = -1;
+
+    // update the artwork (the walkers of the swarm are stepped on the workers)
+    if (on_map){
+        sand_line_task = frame_graph.add("sand_line", [this](){
+            sand_line.update();
+            timelapse.capture(*sand_line.get_fbo_pointer());
+
+            // checkpoint right after drawing: tiles are marked dirty only once
+            // their grains are in the fbo (a stroke finished by the simulation
+            // meanwhile waits for the next update())
+            if (ofGetElapsedTimef() - last_autosave_time > autosave_interval){
+                autosave.checkpoint(*sand_line.get_fbo_pointer(), sand_line.take_dirty_tiles());
+                last_autosave_time = ofGetElapsedTimef();
             }
-            if (pin_num == 8) zoom_in_pressed = value;
-            if (pin_num == 9) zoom_out_pressed = value;
-
-        }
-        else if (m.getAddress() == "/arduino/analog"){
-            
-            int pin_num = m.getArgAsInt(0);
-            float value = m.getArgAsFloat(1);
-
-            // cout << "--------------------" << endl;
-            // cout << "/arduino/analog, " << pin_num << ", " << ofToString(value) << endl;
+        }, {}, true);
+    }
 
-            float joystick_speed_mult = 0.3538f;
-            switch(pin_num){
-                case 0:{
-                    // cout << "analog pin 0!" << endl;
-                    joystick.y = ofMap(value, 1023, 0, -cam_move_speed * joystick_speed_mult, cam_move_speed * joystick_speed_mult);
-                    cout << "joystick.y: " << joystick.y << endl;
-                    break;
-                }
-                case 1:{
-                    // cout << "analog pin 1!" << endl;
-                    //joystick.x = ofMap(value, 1023, 0, -cam_move_speed * joystick_speed_mult, cam_move_speed * joystick_speed_mult);
-                    break;
-                }
-            }
-            analog_status = "joystick x: " + ofToString(joystick.x) + ", y: " + ofToString(joystick.y);
-            
-        }
-        // receive twitter stuff
-        else if (m.getAddress() == "/twitter-app"){
+    // fade out the old tweets
+    density_task = frame_graph.add("density", [this, dt](){
+        tweet_density.decay(dt);
+    });
+    density_upload_task = frame_graph.add("density_upload", [this](){
+        tweet_density.upload();
+    }, {density_task}, true);
+
+    // one color per country, whatever the number of vertices
+    // (the countries are still being tessellated while loading)
+    if (!loading){
+        countries_task = frame_graph.add("countries", [map, dt](){
+            map->country_fill.decay(dt);
+        });
+        countries_upload_task = frame_graph.add("countries_upload", [map](){
+            map->country_fill.upload_colors();
+        }, {countries_task}, true);
+    }
 
-			current_tweeted_city = "#" + m.getArgAsString(0);
-            // if there's no text, we'll have an empty string, otherwise prepend an hashtag
-			current_tweet_hashtags = m.getArgAsString(1).length() == 0 ? "" : "#" + m.getArgAsString(1);
-			std::string current_tweet_nation = m.getArgAsString(2);
-			float lon = m.getArgAsFloat(3);
-			float lat = m.getArgAsFloat(4);
+    // move towards the projection chosen with 'g', the whole map in one batch per frame
+    if (!loading && projection_t != projection_target){
+        reproject_task = frame_graph.add("reproject", [this, map, dt](){
+            float step = dt * 0.5f; // two seconds from one to the other
+            projection_t = projection_target > projection_t ? std::min(projection_target, projection_t + step) : std::max(projection_target, projection_t - step);
+            map->geo_store.reproject(projection_t, geojson_scale);
+            map->labels.set_positions(map->geo_store.get_point_positions());
+        }, {}, true);
+    }
 
-            // cout << "heard a tweet related to: " << current_tweeted_city;
-            // cout << ", nation: " << current_tweet_nation;
-            // cout << ", coordinates: " << lon << ", " << lat << endl;
+    // choose which labels can be drawn without overlapping, once they've been reprojected
+    // (drawing all of them used to cost a good 20-30fps)
+    if (on_map){
+        ofMatrix4x4 model_view_projection = cam.getModelViewProjectionMatrix(ofRectangle(0, 0, WIDTH/2, HEIGHT));
+        labels_task = frame_graph.add("labels", [this, map, model_view_projection](){
+            map->labels.place(model_view_projection, -geoshape_centroid);
+        }, {reproject_task});
+    }
 
-            ofVec3f city_pos;
-            bool found = false;
+    // "last hour" and "today"
+    if (!loading && ofGetElapsedTimef() - last_history_view_time > 1){
+        history_task = frame_graph.add("history", [this](){
+            update_history_view();
+        });
+        last_history_view_time = ofGetElapsedTimef();
+    }
 
-            // if the tweet has the coordinates embedded, use them
-            if (lon != -1 && lat != -1){
-                city_pos = vv_map_projections::mercator(lon, lat, geojson_scale);
-                found = true;
-            }
-            // otherwise we will find them by ourselves by looping through our cities
-            else {
-                for (vv_geojson::City city : cities){
-                    
-                    if (city.name == current_tweeted_city){
-                        city_pos = city.position;
-                        found = true;
-                    }
-
-                    if (found) break;
-                }
-            }
+    // upload the hashtags extruded in the meantime
+    hashtags_task = frame_graph.add("hashtags", [this](){
+        hashtags.update();
+    }, {}, true);
+
+    scheduler.run(frame_graph);
+
+    // the profiler is written only by this thread, the times of the tasks are added here
+    auto add_task_time = [this](int phase, int task){
+        if (task >= 0) profiler.add_sample(phase, frame_graph.get_ms(task) * 1000);
+    };
+    add_task_time(phase_sand_line, sand_line_task);
+    add_task_time(phase_density, density_task);
+    add_task_time(phase_density, density_upload_task);
+    add_task_time(phase_density, countries_task);
+    add_task_time(phase_density, countries_upload_task);
+    add_task_time(phase_reproject, reproject_task);
+    add_task_time(phase_labels, labels_task);
+    add_task_time(phase_history, history_task);
+    add_task_time(phase_hashtags, hashtags_task);
+
+    // serial time against wall time, averaged over a second for the hud
+    tasks_serial_ms += frame_graph.get_serial_ms();
+    tasks_wall_ms += frame_graph.get_wall_ms();
+    tasks_overhead_ms += frame_graph.get_overhead_ms();
+    tasks_frames++;
+    if (ofGetElapsedTimef() - last_tasks_view_time > 1){
+        TaskSchedulerStats scheduler_stats = scheduler.get_stats();
+        tasks_view = "frame tasks: " + ofToString(tasks_serial_ms / tasks_frames, 2) + 
+            " ms serial, " + ofToString(tasks_wall_ms / tasks_frames, 2) + 
+            " ms wall (" + ofToString(tasks_serial_ms / std::max(0.001f, tasks_wall_ms), 2) + 
+            "x), overhead " + ofToString(tasks_overhead_ms / tasks_frames, 2) + 
+            " ms, " + ofToString(scheduler_stats.num_workers) + 
+            " workers, " + ofToString(scheduler_stats.steals) + " steals";
+        tasks_serial_ms = 0;
+        tasks_wall_ms = 0;
+        tasks_overhead_ms = 0;
+        tasks_frames = 0;
+        last_tasks_view_time = ofGetElapsedTimef();
+    }
 
-            // we found the coordinates! well, let's then create a puff of smoke
-            // and a stroke on the artwork
-            if (found){
+    if (history_task >= 0) vv_memory::set(vv_memory::TWEET_HISTORY, tweet_history.get_bytes());
+    vv_memory::set(vv_memory::HASHTAGS, hashtags.get_bytes());
 
-                // keep this deque clean
-                if (fireworks.size() > 15){
-                    fireworks.pop_front();
-                }
+    // the tiles come and go, the rest is counted as it's allocated
+    if (map_tiles.is_enabled()) vv_memory::set(vv_memory::MAP_TILES, map_tiles.get_stats().bytes);
+    if (ofGetElapsedTimef() - last_memory_log_time > memory_log_interval){
+        cout << current_date_time() << " " << vv_memory::get_log_line() << endl;
+        last_memory_log_time = ofGetElapsedTimef();
+    }
 
-                // VISUALIZATION
-                // add a firework to visualize the tweet
-                Firework firework;
-                ofFloatColor col = ofFloatColor(0.0f);
-                firework.setup(city_pos, col);
-                fireworks.push_back(firework);
-
-                // SOUND
-                play_sound_for_nation(current_tweet_nation);
-
-                // DRAWING
-                // use that city in the artwork
-                if (!show_intro_screen){
-
-                    ofPoint screen_pos;
-                    ofFbo * fbo = sand_line.get_fbo_pointer();
-                    screen_pos.x = ofMap(city_pos.x, geoshape_bb.x, geoshape_bb.getWidth(),  0, fbo->getWidth());
-                    screen_pos.y = ofMap(city_pos.y, geoshape_bb.y, geoshape_bb.getHeight(), fbo->getHeight(), 0);
-                    // get the max offset from the second letter of the tweet (first char is the hashtag)
-                    int max_offset;
-                    try {
-                        max_offset = int(current_tweet_hashtags.at(1)) * 0.5f;
-                    }
-                    catch (std::out_of_range &exc){
-                        max_offset = ofRandom(255);
-                    }
-                    // get the max radius from the length of the tweet
-                    int max_radius = ofClamp(int(current_tweet_hashtags.length()), 32, 64);
-                    // cout << "adding line with max offset: " << max_offset << endl;
-
-                    // pick a random drawing mode
-                    int drawing_mode = (ofRandom(1) > 0.75 ? SandLine::ATTRACTOR_MODE : SandLine::BEZIER_MODE);
-                    sand_line.set_mode(drawing_mode);
-                    sand_line.set_target(screen_pos);
-                    sand_line.add_point(screen_pos, max_offset, max_radius);
-                }
-            }
-            else {
-                cerr << "!!!!!!ATTENTION!!!!!!" << endl;
-                cerr << "city " << current_tweeted_city << " not found!" << endl;
-            }
-		}
+    // what the tweets handled by the simulation left for the main thread
+    {
+        ProfileScope scope(profiler, phase_tweets);
+        deque <TweetEvent> events;
+        {
+            std::unique_lock<std::mutex> lock(tweet_events_mutex);
+            events.swap(tweet_events);
+        }
+        for (int e = 0; e < events.size(); e++){
+            apply_tweet_event(events[e]);
+        }
     }
 
     // update the sound playing system
@@ -291,7 +525,8 @@ void ofApp::update(){
 //--------------------------------------------------------------
 void ofApp::draw(){
 
-    if (show_intro_screen){
+    // a restored session still waits for the map behind the intro screen
+    if (show_intro_screen || !assets.is_done()){
         
         ofPushStyle();
         
@@ -299,19 +534,24 @@ void ofApp::draw(){
         ofSetColor(255);
         ofFill();
 
-        std::stringstream description;
-        description << "Welcome.\n\n";
-        description << "On the right side of the screen you will see a drawing generated\n";
-        description << "from a real time stream of people tweeting stuff about different cities.\n\n";
-        description << "On the left side, you have the chance explore a map of those tweets\n";
-        description << "using the joystick and the buttons.\n\n";
-        description << "When you're ready, press the joystick to start.";
-        font.drawString(description.str(), WIDTH/3, HEIGHT/4);
+        // the intro text never changes, it's laid out only once
+        profiler.begin(phase_text_draw);
+        intro_text_cache.set("intro", font, intro_text, WIDTH/3, HEIGHT/4);
+        if (!assets.is_done()){
+            intro_text_cache.set("loading", font, "loading... " + ofToString(assets.get_num_done()) + "/" + ofToString(assets.get_num_jobs()), WIDTH/3, HEIGHT - HEIGHT/4);
+        }
+        else intro_text_cache.set("loading", font, "", WIDTH/3, HEIGHT - HEIGHT/4);
+        intro_text_cache.draw();
+        profiler.end(phase_text_draw);
 
         ofPopStyle();
     }
     else {
 
+        MapData & map = *map_data;
+
+        profiler.begin(phase_map_draw);
+
         threed_map_fbo.begin();
 
         ofPushStyle();
@@ -324,8 +564,9 @@ void ofApp::draw(){
 
         ofEnableDepthTest();
 
-        cam.setPosition(cam_position); // see compute_cam_movement()
-        cam.setOrientation(cam_orientation);
+        // the camera was placed in update(), from the simulation
+
+        // (the labels to draw were chosen in update())
 
         cam.begin();
 
@@ -335,58 +576,46 @@ void ofApp::draw(){
         ofTranslate(-geoshape_centroid);
 
         
-        // draw the vbo meshes for the polygons
+        // the density of the recent tweets, under everything else
+        // (it's a flat texture, only for the mercator map)
+        if (projection_t == 0) tweet_density.draw();
+        // the countries, filled by their tweets (tessellated on mercator too)
+        if (projection_t == 0) map.country_fill.draw();
+
+        // draw the quantized outlines of the polygons
         ofSetColor(255, 0, 0);
-        for (ofMesh polymesh: poly_meshes){
-            polymesh.draw();
+        if (projection_t > 0){
+            ofPushStyle();
+            ofSetColor(0);
+            map.geo_store.draw();
+            ofPopStyle();
         }
+        else if (map_tiles.is_enabled()) map_tiles.draw();
+        else map.geometry.draw_all();
 
-        /*
-        // draw the text of each city
-        
-        for (vv_geojson::City city : cities){
-            ofPushMatrix();
-
-                // check if the city can actually be seen from the camera
-                // otherwise don't even bother doing all this stuff (this saves a good 20-30fps)
-                ofPoint city_screen_pos = cam.worldToScreen(city.position);
-                if (city_screen_pos.x > 0 && city_screen_pos.x < WIDTH/2){
-                    if (city_screen_pos.y > 0 && city_screen_pos.y < HEIGHT){
-                
-                        ofTranslate(city.position);
-                        ofTranslate(0, 0, -0.1f);
-                        ofRotateX(-90);
-                        // ofScale(0.02, 0.02, 0.02);
-                        for (ofMesh citymesh : city.meshes){
-                            citymesh.draw();
-                        }
-                    }
-                } 
-            ofPopMatrix();
-        }
-        */
+        // draw the text of the cities chosen by the label placer
+        map.labels.draw();
+
+        // and the hashtags of the last tweets above them
+        hashtags.draw();
 
         // FIREWORKS
         ofEnablePointSprites();
         ofSetColor(255);
 
-        for (int f = 0; f < fireworks.size(); f++){
+        for (int f = 0; f < view_state.fireworks.size(); f++){
             
-            Firework * firework = &fireworks.at(f);
+            const FireworkView & firework = view_state.fireworks[f];
 
             // draw a small sphere before the puff explosion
-            if (!firework->exploded()){
-                ofDrawSphere(
-                    firework->initial_particle.position.x,
-                    firework->initial_particle.position.y,
-                    firework->initial_particle.position.z,
-                    0.23);
+            if (!firework.exploded){
+                ofDrawSphere(firework.position.x, firework.position.y, firework.position.z, 0.23);
             }
             else {
                 // all points drawn after the bind will be displayed
                 // as the texture instead
                 firework_texture.bind();
-                firework->mesh.draw();
+                firework.mesh->draw();
                 firework_texture.unbind();
             }
         }
@@ -399,17 +628,57 @@ void ofApp::draw(){
 
         ofDisableDepthTest();
 
+        profiler.end(phase_map_draw);
+
         // 2D STUFF
 
+        profiler.begin(phase_text_draw);
+
         // DATA 
         ofPushStyle();
 
         ofSetColor(0);
         ofFill();
-        font.drawString(current_tweeted_city, 20, 30);
-        font.drawString(current_tweet_hashtags, WIDTH/8, 30);
-        font.drawString("fps: " + ofToString(ofGetFrameRate()), WIDTH/8, 50);
-        font.drawString("\nPress the joystick to save the current image and exit.", WIDTH - WIDTH/8, HEIGHT-HEIGHT/8);
+        // strings are laid out again only when they change, so keep the numbers rounded
+        hud_text_cache.set("city", font, current_tweeted_city, 20, 30);
+        hud_text_cache.set("hashtags", font, current_tweet_hashtags, WIDTH/8, 30);
+        SimulationStats sim_stats = simulation.get_stats();
+        hud_text_cache.set("fps", font, "fps: " + ofToString(int(ofGetFrameRate())) + 
+            ", walkers: " + ofToString(sand_line.swarm.size()) + 
+            ", steps/s: " + ofToString(int(sand_line.swarm.get_steps_per_second())) + 
+            ", sim: " + ofToString(int(sim_stats.rate)) + " Hz, max " + ofToString(sim_stats.max_step_ms, 1) + 
+            " ms, dropped: " + ofToString(sim_stats.dropped_ticks), WIDTH/8, 50);
+        hud_text_cache.set("footer", font, "\nPress the joystick to save the current image and exit.", WIDTH - WIDTH/8, HEIGHT-HEIGHT/8);
+        hud_text_cache.set("history", font, history_view, WIDTH/8, 130);
+        hud_text_cache.set("tasks", font, tasks_view, WIDTH/8, 150);
+        hud_text_cache.set("trending", font, trending_view, WIDTH/8, 170);
+        if (timelapse.is_recording()){
+            TimelapseStats timelapse_stats = timelapse.get_stats();
+            hud_text_cache.set("timelapse", font, "time-lapse: " + ofToString(timelapse_stats.captured) +
+                " captured, " + ofToString(timelapse_stats.dropped) + " dropped, " + ofToString(timelapse_stats.queued) + " queued", WIDTH/8, 190);
+        }
+        else hud_text_cache.set("timelapse", font, "", WIDTH/8, 190);
+        hud_text_cache.set("quality", font, governor.get_status(), WIDTH/8, 210);
+        LabelStats label_stats = map.labels.get_stats();
+        hud_text_cache.set("labels", font, "labels placed: " + ofToString(label_stats.placed) + 
+            "/" + ofToString(label_stats.tested) + 
+            ", offscreen: " + ofToString(label_stats.rejected_offscreen) + 
+            ", overlap: " + ofToString(label_stats.rejected_overlap) + 
+            ", budget: " + ofToString(label_stats.rejected_budget), WIDTH/8, 70);
+        if (map_tiles.is_enabled()){
+            TileStreamerStats tile_stats = map_tiles.get_stats();
+            hud_text_cache.set("tiles", font, "tiles in view: " + ofToString(tile_stats.in_view) + 
+                ", resident: " + ofToString(tile_stats.resident) + 
+                " (" + ofToString(tile_stats.bytes / 1024) + " KB)" + 
+                ", pending: " + ofToString(tile_stats.pending), WIDTH/8, 90);
+        }
+        if (projection_t > 0){
+            hud_text_cache.set("projection", font, "globe: " + ofToString(int(projection_t * 100)) + 
+                "%, " + ofToString(map.geo_store.get_num_vertices()) + 
+                " vertices reprojected in " + ofToString(map.geo_store.get_last_reproject_ms(), 1) + " ms", WIDTH/8, 110);
+        }
+        else hud_text_cache.set("projection", font, "", WIDTH/8, 110);
+        hud_text_cache.draw();
         // ofDrawBitmapString("fps: " + ofToString(ofGetFrameRate()), 20, 50); // for debugging
         
         if (joystick_pressed) ofDrawBitmapString("saving artwork!", 20, 70);
@@ -418,15 +687,322 @@ void ofApp::draw(){
 
         threed_map_fbo.end();
 
+        profiler.end(phase_text_draw);
+
+        profiler.begin(phase_composite);
+
         // ARTWORK        
         ofFbo * art_fbo = sand_line.get_fbo_pointer();
         art_fbo->draw(WIDTH/2, 0);
 
         // DRAW THE 3D ENVIRONMENT
         threed_map_fbo.draw(0, 0);
+
+        profiler.end(phase_composite);
+    }
+
+    // PROFILING
+    profiler.draw(20, HEIGHT/4);
+    sim_profiler.draw(420, HEIGHT/4); // read only, the simulation thread writes it
+    profiler.end_frame();
+
+    // QUALITY
+    // only the frames on the map count, loading and the intro screen are something else;
+    // the governor skips its first second too, the last uploads of the loading end up there
+    if (!show_intro_screen && assets.is_done()){
+        float work_ms = (ofGetElapsedTimeMicros() - frame_start_time) / 1000.0f;
+        if (governor.update(ofGetLastFrameTime() * 1000, work_ms)) apply_quality();
+    }
+}
+
+//--------------------------------------------------------------
+// @desc:   hands the settings of the current quality level to whoever uses
+//          them; the label budget goes to the map every frame instead, it
+//          can be swapped for a new one (see update())
+//--------------------------------------------------------------
+void ofApp::apply_quality(){
+
+    const QualityLevel & quality = governor.get_settings();
+    sand_line.grains_per_step = quality.grains_per_step;
+    Firework::particles_per_explosion = quality.particles_per_explosion;
+    max_fireworks = quality.max_fireworks;
+    map_tiles.lod_bias = quality.map_lod_bias;
+    vv_metrics::set(vv_metrics::QUALITY_LEVEL, governor.get_level());
+
+    // a new fbo only when the samples change, it's drawn from scratch every frame anyway
+    if (quality.msaa_samples != threed_map_samples){
+        threed_map_samples = quality.msaa_samples;
+        threed_map_fbo.allocate(WIDTH/2, HEIGHT, GL_RGBA, threed_map_samples);
+    }
+}
+
+
+//--------------------------------------------------------------
+// SIMULATION
+//--------------------------------------------------------------
+// @desc:   one tick of the simulation thread: osc messages, tweets,
+//          fireworks and camera physics, then the snapshot of all of them
+//--------------------------------------------------------------
+void ofApp::simulate(SimSnapshot & next, float dt){
+
+    // check for osc messages
+    sim_profiler.begin(phase_sim_osc);
+	while (osc_receiver.hasWaitingMessages()){
+        ofxOscMessage m;
+        osc_receiver.getNextMessage(m);
+
+        // receive arduino stuff
+        if (m.getAddress() == "/arduino/digital"){
+            
+            int pin_num = m.getArgAsInt(0);
+            int value = m.getArgAsInt32(1);
+
+            // cout << "--------------------" << endl;
+            // cout << "/arduino/digital, " << pin_num << ", " << value << endl;
+
+            if (pin_num == 2){
+                joystick_pressed = !value;
+            }
+            if (pin_num == 8) zoom_in_pressed = value;
+            if (pin_num == 9) zoom_out_pressed = value;
+
+        }
+        else if (m.getAddress() == "/arduino/analog"){
+            
+            int pin_num = m.getArgAsInt(0);
+            float value = m.getArgAsFloat(1);
+
+            // cout << "--------------------" << endl;
+            // cout << "/arduino/analog, " << pin_num << ", " << ofToString(value) << endl;
+
+            float joystick_speed_mult = 0.3538f;
+            switch(pin_num){
+                case 0:{
+                    // cout << "analog pin 0!" << endl;
+                    joystick.y = ofMap(value, 1023, 0, -cam_move_speed * joystick_speed_mult, cam_move_speed * joystick_speed_mult);
+                    cout << "joystick.y: " << joystick.y << endl;
+                    break;
+                }
+                case 1:{
+                    // cout << "analog pin 1!" << endl;
+                    //joystick.x = ofMap(value, 1023, 0, -cam_move_speed * joystick_speed_mult, cam_move_speed * joystick_speed_mult);
+                    break;
+                }
+            }
+            analog_status = "joystick x: " + ofToString(joystick.x) + ", y: " + ofToString(joystick.y);
+            
+        }
+        // receive twitter stuff
+        // tweets need the cities, the ones arriving while loading are dropped
+        else if (m.getAddress() == "/twitter-app"){
+            vv_metrics::increment(vv_metrics::TWEETS_RECEIVED);
+            if (sim_loaded){
+                ProfileScope scope(sim_profiler, phase_sim_tweets);
+                handle_tweet(m);
+            }
+            else vv_metrics::increment(vv_metrics::TWEETS_DROPPED);
+        }
+    }
+    sim_profiler.end(phase_sim_osc);
+
+    if (sim_active){
+
+        // update the dataviz
+        sim_profiler.begin(phase_sim_fireworks);
+        int num_particles = 0;
+        for (Firework & firework : fireworks){
+            firework.update();
+            num_particles += firework.particles.size();
+        }
+        vv_metrics::set(vv_metrics::FIREWORKS, fireworks.size());
+        vv_metrics::set(vv_metrics::FIREWORK_PARTICLES, num_particles);
+        sim_profiler.end(phase_sim_fireworks);
+
+        sim_profiler.begin(phase_sim_camera);
+        if (zoom_in_pressed) cam_zoom_in();
+        if (zoom_out_pressed) cam_zoom_out();
+        
+        // move and orient camera
+        compute_cam_movement();
+        compute_cam_orientation();
+        sim_profiler.end(phase_sim_camera);
+    }
+
+    next.cam_position = cam_position;
+    next.cam_orientation = get_cam_quaternion();
+    next.cam_move_velocity = cam_move_velocity;
+    next.fireworks.resize(fireworks.size());
+    for (int f = 0; f < fireworks.size(); f++){
+        FireworkState & state = next.fireworks[f];
+        state.id = num_fireworks_created - fireworks.size() + f;
+        state.exploded = fireworks[f].exploded();
+        state.position = fireworks[f].initial_particle.position;
+        if (state.exploded) state.mesh = fireworks[f].mesh;
+    }
+
+    sim_profiler.end_frame();
+}
+
+//--------------------------------------------------------------
+// @desc:   finds the tweet on the map, adds its firework and its stroke on the
+//          artwork; everything else is queued for apply_tweet_event()
+//--------------------------------------------------------------
+void ofApp::handle_tweet(ofxOscMessage & m){
+
+    TweetEvent tweet;
+    tweet.time = time(NULL);
+	tweet.city = "#" + m.getArgAsString(0);
+    // if there's no text, we'll have an empty string, otherwise prepend an hashtag
+	tweet.hashtags = m.getArgAsString(1).length() == 0 ? "" : "#" + m.getArgAsString(1);
+	tweet.nation = m.getArgAsString(2);
+	tweet.lon = m.getArgAsFloat(3);
+	tweet.lat = m.getArgAsFloat(4);
+
+    // cout << "heard a tweet related to: " << tweet.city;
+    // cout << ", nation: " << tweet.nation;
+    // cout << ", coordinates: " << tweet.lon << ", " << tweet.lat << endl;
+
+    // city_pos is always on mercator, the artwork and the density use it
+    // view_pos is in the current projection, for everything drawn on the map
+    tweet.found = false;
+    tweet.city_index = -1;
+
+    // if the tweet has the coordinates embedded, use them
+    // (the closest label is found on the main thread, where the labels are)
+    if (tweet.lon != -1 && tweet.lat != -1){
+        tweet.city_pos = vv_map_projections::mercator(tweet.lon, tweet.lat, geojson_scale);
+        tweet.view_pos = GeoStore::project(tweet.lon, tweet.lat, projection_t, geojson_scale);
+        tweet.found = true;
     }
+    // otherwise we will find them by ourselves by looping through our cities
+    // (the map can be swapped by the main thread meanwhile, this one stays alive until we're done)
+    else {
+        std::shared_ptr <MapData> map = std::atomic_load(&map_data);
+        const vector <vv_geojson::City> & cities = map->cities;
+        for (int c = 0; c < cities.size(); c++){
+            
+            if (cities[c].name == tweet.city){
+                tweet.city_pos = cities[c].position;
+                tweet.view_pos = map->geo_store.project_point(c, projection_t, geojson_scale);
+                tweet.city_index = c;
+                tweet.found = true;
+            }
+
+            if (tweet.found) break;
+        }
+    }
+
+    // we found the coordinates! well, let's then create a puff of smoke
+    // and a stroke on the artwork
+    if (tweet.found){
+
+        // keep this deque clean
+        while (fireworks.size() >= std::max(1, int(max_fireworks))){
+            fireworks.pop_front();
+        }
+
+        // VISUALIZATION
+        // add a firework to visualize the tweet
+        Firework firework;
+        ofFloatColor col = ofFloatColor(0.0f);
+        firework.setup(tweet.view_pos, col);
+        fireworks.push_back(firework);
+        num_fireworks_created++;
+
+        // DRAWING
+        // use that city in the artwork
+        if (!show_intro_screen){
+
+            ofPoint screen_pos;
+            ofFbo * fbo = sand_line.get_fbo_pointer();
+            screen_pos.x = ofMap(tweet.city_pos.x, geoshape_bb.x, geoshape_bb.getWidth(),  0, fbo->getWidth());
+            screen_pos.y = ofMap(tweet.city_pos.y, geoshape_bb.y, geoshape_bb.getHeight(), fbo->getHeight(), 0);
+            // get the max offset from the second letter of the tweet (first char is the hashtag)
+            int max_offset;
+            try {
+                max_offset = int(tweet.hashtags.at(1)) * 0.5f;
+            }
+            catch (std::out_of_range &exc){
+                max_offset = ofRandom(255);
+            }
+            // get the max radius from the length of the tweet
+            int max_radius = ofClamp(int(tweet.hashtags.length()), 32, 64);
+            // cout << "adding line with max offset: " << max_offset << endl;
+
+            // pick a random drawing mode
+            // (the grains are generated here, the main thread only draws them)
+            int drawing_mode = (ofRandom(1) > 0.75 ? SandLine::ATTRACTOR_MODE : SandLine::BEZIER_MODE);
+            sand_line.set_mode(drawing_mode);
+            sand_line.set_target(screen_pos);
+            sand_line.add_point(screen_pos, max_offset, max_radius);
+        }
+    }
+    else {
+        vv_metrics::increment(vv_metrics::CITY_MISSES);
+        cerr << "!!!!!!ATTENTION!!!!!!" << endl;
+        cerr << "city " << tweet.city << " not found!" << endl;
+    }
+
+    std::unique_lock<std::mutex> lock(tweet_events_mutex);
+    tweet_events.push_back(tweet);
 }
 
+//--------------------------------------------------------------
+// @desc:   the part of a tweet that touches what the main thread owns:
+//          labels, history, density, countries, hashtags and sound
+//--------------------------------------------------------------
+void ofApp::apply_tweet_event(TweetEvent & tweet){
+
+    vv_metrics::increment(vv_metrics::TWEETS_PROCESSED);
+
+    current_tweeted_city = tweet.city;
+    current_tweet_hashtags = tweet.hashtags;
+
+    MapData & map = *map_data;
+
+    // the label of the closest city gets the credit
+    int city_index = tweet.city_index;
+    if (tweet.lon != -1 && tweet.lat != -1) city_index = map.labels.find_nearest_city(tweet.view_pos, 5);
+
+    // busy cities get their labels drawn first
+    map.labels.notify_activity(city_index);
+
+    // the coordinates know which country to light up better than the nation that comes
+    // with the tweet, which can be missing or wrong; it's still there for the tweets
+    // without them, or when the point falls outside every country (the sea).
+    // The sent nation itself is kept for the sounds and the history: the names of the
+    // geojson are spelled differently ("United States of America"), only a missing one is filled
+    int country = -1;
+    if (tweet.lon != -1 && tweet.lat != -1) country = map.country_locator.find(tweet.city_pos);
+    if (country < 0) country = map.country_fill.find_country(tweet.nation);
+    else if (tweet.nation.empty()) tweet.nation = map.country_locator.get_name(country);
+
+    // by name, the indices change when the map is reloaded
+    std::string city_name = city_index >= 0 && city_index < map.cities.size() ? map.cities[city_index].name : "";
+    tweet_history.add(tweet.time, city_name, tweet.nation, tweet.lon, tweet.lat, tweet.hashtags);
+
+    // every hashtag of the tweet counts for the trends, whatever the case
+    std::stringstream words(tweet.hashtags);
+    std::string word;
+    while (words >> word){
+        if (word[0] != '#') word = "#" + word;
+        if (word.size() > 1) trending_hashtags.add(ofToLower(word));
+    }
+    if (tweet.found) trending_cities.add(tweet.city);
+
+    map.country_fill.notify_activity(country);
+
+    if (!tweet.found) return;
+
+    // every tweet counts for the density, not only the last fireworks
+    tweet_density.add(tweet.city_pos);
+
+    // the hashtag floats over the city, once the worker has extruded it
+    hashtags.add(tweet.hashtags, tweet.view_pos);
+
+    // SOUND
+    play_sound_for_nation(tweet.nation);
+}
 
 //--------------------------------------------------------------
 // CAMERA
@@ -458,6 +1034,15 @@ void ofApp::compute_cam_movement(){
     cam_move_acceleration = ofVec3f(0, 0, 0);
 }
 
+//--------------------------------------------------------------
+// @desc:   the euler angles of the camera as a quaternion, the same way
+//          ofNode::setOrientation(ofVec3f) does it: blending the angles
+//          themselves would spin the wrong way around near 180 degrees
+//--------------------------------------------------------------
+ofQuaternion ofApp::get_cam_quaternion(){
+    return ofQuaternion(cam_orientation.x, ofVec3f(1, 0, 0), cam_orientation.z, ofVec3f(0, 0, 1), cam_orientation.y, ofVec3f(0, 1, 0));
+}
+
 //--------------------------------------------------------------
 void ofApp::compute_cam_orientation(){
 
@@ -519,54 +1104,35 @@ void ofApp::play_sound_for_nation(std::string nation){
     bool is_greek = (nation == "Greece");
 
     // randomize speed of the samples so they don't sound always exactly the same
+    // (this only queues the sound, the mixing happens on the audio thread)
     float speed = ofRandom(0.85, 1.1);
     if (is_orient){
         // cout << "is orient" << endl;
-        chatting_sound_jp.stop();
-        // chatting_sound_jp.setSpeed(speed);
-        // chatting_sound_jp.setPositionMS(ofRandom(32 * 1000));
-        chatting_sound_jp.play();
+        mixer.trigger(chatting_sound_jp, 1.0f, 0);
     }
     else if (is_english){
         // cout << "is english" << endl;
-        chatting_sound_en.stop();
-        chatting_sound_en.setSpeed(speed);
-        chatting_sound_es.setPositionMS(ofRandom(120 * 1000));
-        chatting_sound_en.play();
+        mixer.trigger(chatting_sound_en, speed, ofRandom(120));
     }
     else if (is_spanish) {
         // cout << "is spanish" << endl;
-        chatting_sound_es.stop();
-        chatting_sound_es.setSpeed(speed);
-        chatting_sound_es.setPositionMS(ofRandom(60 * 1000));
-        chatting_sound_es.play();
+        mixer.trigger(chatting_sound_es, speed, ofRandom(60));
     }
     else if (is_french) {
         // cout << "is french" << endl;
-        chatting_sound_fr.stop();
-        chatting_sound_fr.setSpeed(speed);
-        chatting_sound_fr.play();
+        mixer.trigger(chatting_sound_fr, speed, 0);
     }
     else if (is_german){
         // cout << "is_german" << endl;
-        chatting_sound_de.stop();
-        chatting_sound_de.setSpeed(speed);
-        chatting_sound_de.setPositionMS(ofRandom(35 * 1000));
-        chatting_sound_de.play();
+        mixer.trigger(chatting_sound_de, speed, ofRandom(35));
     }
     else if (is_greek){
         // cout << "is_greek" << endl;
-        chatting_sound_gr.stop();
-        chatting_sound_gr.setSpeed(speed);
-        chatting_sound_gr.setPositionMS(ofRandom(35 * 1000));
-        chatting_sound_gr.play();
+        mixer.trigger(chatting_sound_gr, speed, ofRandom(35));
     }
     else if (is_italian){
         // cout << "is_italian" << endl;
-        chatting_sound_it.stop();
-        chatting_sound_it.setSpeed(speed);
-        chatting_sound_it.setPositionMS(ofRandom(35 * 1000));
-        chatting_sound_it.play();
+        mixer.trigger(chatting_sound_it, speed, ofRandom(35));
     }
 }
 
@@ -581,8 +1147,8 @@ void ofApp::mousePressed(int x, int y, int button){
     cout << "cam.getGlobalPosition():    " << cam.getGlobalPosition() << endl;
     cout << "cam.getGlobalOrientation(): " << cam.getGlobalOrientation() << endl;
     cout << "cam.getDistance():          " << cam.getDistance() << endl;
-    cout << "cam_orientation: " << cam_orientation << endl;
-    cout << "cam_position:    " << cam_position << endl;
+    cout << "cam_orientation: " << view_state.cam_orientation.getEuler() << endl;
+    cout << "cam_position:    " << view_state.cam_position << endl;
 }
 
 //--------------------------------------------------------------
@@ -591,6 +1157,39 @@ void ofApp::keyPressed(int key){
     // FOR DEBUGGING when the arduino is not plugged
     // (movements are not as smooth as with the joystick, but still)
     switch (key){
+        // PROFILING
+        case 'p': {
+            profiler.show_overlay = !profiler.show_overlay;
+            sim_profiler.show_overlay = profiler.show_overlay;
+            break;
+        }
+        case 'c': {
+            profiler.dump_csv("profile_" + current_date_time() + ".csv");
+            sim_profiler.dump_csv("sim_profile_" + current_date_time() + ".csv");
+            break;
+        }
+        // PROJECTION
+        case 'g': {
+            projection_target = projection_target == 0 ? 1 : 0;
+            break;
+        }
+        // MEMORY
+        case 'm': {
+            cout << vv_memory::get_report();
+            break;
+        }
+        // TIME-LAPSE
+        // from the next visitor on, or right now if somebody's drawing
+        case 't': {
+            timelapse_enabled = !timelapse_enabled;
+            cout << "time-lapse " << (timelapse_enabled ? "on" : "off") << endl;
+            if (timelapse_enabled && final_greet) timelapse.begin("artwork_" + current_date_time());
+            if (!timelapse_enabled && timelapse.is_recording()){
+                timelapse.end();
+                log_timelapse();
+            }
+            break;
+        }
         // CAMERA MOVEMENTS
         // case '[': {
         //     cam_zoom_in();
@@ -685,6 +1284,54 @@ void ofApp::save_fbo(ofFbo * fbo, std::string path){
     out_image.save(path);
 }
 
+//--------------------------------------------------------------
+// the frames still queued are written after this, the counts can be a bit behind
+//--------------------------------------------------------------
+void ofApp::log_timelapse(){
+
+    TimelapseStats stats = timelapse.get_stats();
+    cout << "time-lapse: " << stats.captured << " frames captured, " << stats.dropped << " dropped (disk too slow), ";
+    cout << stats.written << " written, " << stats.bytes_written / (1024 * 1024) << " MB, last one in " << stats.last_write_ms << " ms" << endl;
+}
+
+//--------------------------------------------------------------
+// HISTORY
+//--------------------------------------------------------------
+void ofApp::update_history_view(){
+
+    time_t now = time(NULL);
+    struct tm midnight = *localtime(&now);
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    uint32_t today = mktime(&midnight);
+
+    int last_hour = tweet_history.count_range(now - 3600, now + 1);
+    int since_midnight = tweet_history.count_range(today, now + 1);
+
+    // the busiest city of the last hour
+    vector <int> city_counts;
+    tweet_history.count_by_city(now - 3600, now + 1, city_counts);
+    int busiest = -1;
+    for (int c = 0; c < city_counts.size(); c++){
+        if (city_counts[c] > 0 && (busiest < 0 || city_counts[c] > city_counts[busiest])) busiest = c;
+    }
+
+    history_view = "last hour: " + ofToString(last_hour) + " tweets, today: " + ofToString(since_midnight);
+    if (busiest >= 0) history_view += ", busiest: " + tweet_history.get_city_name(busiest) + " (" + ofToString(city_counts[busiest]) + ")";
+
+    // trending, from the sketches (the counts fade with time, they're not tweets anymore)
+    vector <TrendTracker::Trend> top_hashtags = trending_hashtags.get_top();
+    vector <TrendTracker::Trend> top_cities = trending_cities.get_top();
+    trending_view = "";
+    for (int t = 0; t < top_hashtags.size() && t < 5; t++){
+        trending_view += (t == 0 ? "trending: " : ", ") + top_hashtags[t].key + " " + ofToString(top_hashtags[t].count, 1);
+    }
+    for (int t = 0; t < top_cities.size() && t < 3; t++){
+        trending_view += (t == 0 ? " | cities: " : ", ") + top_cities[t].key + " " + ofToString(top_cities[t].count, 1);
+    }
+}
+
 //--------------------------------------------------------------
 // used to save the image with the current time
 // grabbed from https://stackoverflow.com/questions/997946/how-to-get-current-time-and-date-in-c
@@ -706,6 +1353,25 @@ std::string ofApp::current_date_time() {
 void ofApp::exit(){
 
     ofFbo * fbo = sand_line.get_fbo_pointer();
+
+    // no more tweets, then wait for a job still running, it might be using the cities below
+    metrics_server.stop();
+    simulation.stop();
+    map_reloader.stop();
+    assets.stop();
+    scheduler.stop();
+    map_tiles.stop();
+    hashtags.stop();
+    sound_stream.close();
+
+    // whatever was read back gets written before the thread goes
+    timelapse.end();
+    timelapse.stop();
+    log_timelapse();
+
+    // a clean exit means the artwork is saved below, the checkpoints are not needed anymore
+    autosave.stop();
+    autosave.clear_store();
     
     cout << "saving fbo...";
     save_fbo(fbo, current_date_time() + ".png");
@@ -714,7 +1380,7 @@ void ofApp::exit(){
 
     // add the names of the cities on the fbo
     ofSetColor(255, 65);
-    for (vv_geojson::City city : cities){
+    for (vv_geojson::City city : map_data->cities){
 
         ofPoint screen_pos;
         screen_pos.x = ofMap(city.position.x, geoshape_bb.x, geoshape_bb.getWidth(),  0, fbo->getWidth());
@@ -4,10 +4,43 @@
 #include "ofxOsc.h"
 #include "Firework.h"
 #include "SandLine.h"
+#include "TileAutosave.h"
+#include "TimelapseRecorder.h"
+#include "MetricsServer.h"
+#include "QualityGovernor.h"
+#include "FrameProfiler.h"
+#include "TextMeshCache.h"
+#include "LabelPlacer.h"
+#include "TileStreamer.h"
+#include "VoiceMixer.h"
+#include "DensityLayer.h"
+#include "AssetLoader.h"
+#include "HashtagExtruder.h"
+#include "GeoStore.h"
+#include "CountryFill.h"
+#include "MapData.h"
+#include "MapReloader.h"
+#include "TweetHistory.h"
+#include "TrendTracker.h"
+#include "SimulationThread.h"
+#include "TaskScheduler.h"
+#include "vv_trace.h"
+#include "vv_memory.h"
 #include "vv_geojson.h"
 #include "globals.h"
 #include <time.h>
 
+// what's left of a tweet handled on the simulation thread, for the main one (see apply_tweet_event())
+struct TweetEvent {
+	time_t time;
+	std::string city, hashtags, nation;
+	float lon, lat; // -1 when the tweet has no coordinates
+	bool found; // the city or the coordinates are on the map
+	int city_index; // -1 if not one of ours
+	ofPoint city_pos; // on mercator
+	ofPoint view_pos; // in the projection of the moment
+};
+
 class ofApp : public ofBaseApp{
 
 	public:
@@ -24,16 +57,19 @@ class ofApp : public ofBaseApp{
 		void play_sound_for_nation(std::string nation);
 		void save_fbo(ofFbo * fbo, std::string path);
 
-		bool show_intro_screen;
+		std::atomic <bool> show_intro_screen; // also read by the simulation
+		AssetLoader assets; // sounds, map and labels, loaded behind the intro screen
 		bool final_greet;
 		int arduino_digital_events_counter;
 
 		// FBO for the 3d environment
 		ofFbo threed_map_fbo;
+		int threed_map_samples; // msaa, set by the governor
 
 		// ARDUINO
 		ofArduino arduino;
-		bool joystick_pressed, zoom_in_pressed, zoom_out_pressed;
+		std::atomic <bool> joystick_pressed; // set by the simulation, handled in update()
+		bool zoom_in_pressed, zoom_out_pressed; // simulation thread only
     	string analog_status;
 		ofVec2f joystick;
 
@@ -41,21 +77,43 @@ class ofApp : public ofBaseApp{
 		ofxOscReceiver osc_receiver;
 		std::string current_tweeted_city;
 		std::string current_tweet_hashtags;
+		std::mutex tweet_events_mutex;
+		deque <TweetEvent> tweet_events; // from the simulation thread
+		void handle_tweet(ofxOscMessage & m); // simulation thread
+		void apply_tweet_event(TweetEvent & tweet); // main thread
+		TweetHistory tweet_history; // every tweet received, see update_history_view()
+		std::string history_view; // "last hour" and "today", refreshed every second
+		float last_history_view_time;
+		void update_history_view();
+		TrendTracker trending_hashtags, trending_cities; // in fixed memory, however many come through
+		std::string trending_view; // refreshed with the history view
 
 		// 3D
 		ofEasyCam cam;
 		float text_scale;
 		// Firework firework;
-		deque <Firework> fireworks;
+		deque <Firework> fireworks; // simulation thread only, drawn from view_state
+		int num_fireworks_created; // the id of a firework is its position in this count
 		ofTexture firework_texture;
-
-		// camera
+		DensityLayer tweet_density; // all the recent tweets, fading out
+		HashtagExtruder hashtags; // the hashtags of the last tweets, in 3d over their city
+
+		// SIMULATION
+		// camera physics, fireworks and tweets run at a fixed rate on their own thread,
+		// update() and draw() only see the snapshots it publishes
+		SimulationThread simulation;
+		SimView view_state; // interpolated, the one drawn this frame
+		std::atomic <bool> sim_loaded, sim_active; // set by update(): tweets, and the rest, can go
+		void simulate(SimSnapshot & next, float dt);
+
+		// camera (simulation thread only)
 		float cam_move_speed, cam_orient_speed;
 		ofPoint cam_position;
 		ofVec3f cam_move_velocity, cam_move_acceleration;
 		ofVec3f cam_orientation, cam_orient_velocity, cam_orient_acceleration;
 		void compute_cam_movement();
 		void compute_cam_orientation();
+		ofQuaternion get_cam_quaternion(); // of cam_orientation, blended by the render thread
 		void cam_zoom_in();
     	void cam_zoom_out();
 
@@ -70,25 +128,82 @@ class ofApp : public ofBaseApp{
 		//ofPoint spherical_to_cartesian(float lon, float lat, float radius);
 		ofxJSONElement geojson_map;
 
-		vector <ofMesh> poly_meshes; // stores the geojson shapes
-		vector <vv_geojson::City> cities; // stores the extruded names of the cities
+		std::string map_path;
+		// outlines, countries, cities and labels, as loaded from map_path.
+		// the simulation reads it with std::atomic_load(), only update() replaces it
+		std::shared_ptr <MapData> map_data;
+		MapReloader map_reloader; // loads the map again when the file changes
+		vector <std::shared_ptr<MapData> > retired_maps; // replaced, released on this thread once nobody uses them
+		std::shared_ptr <MapData> pending_map; // reloaded, uploaded a slice per frame until it's swapped in
+		int pending_map_frames;
+		float pending_map_max_ms; // the longest slice
+		TileStreamer map_tiles; // replaces the outlines of map_data when a tile pyramid is found in bin/data/tiles
+		std::atomic <float> projection_t; // 0 mercator, 1 globe ('g' switches), also read by the simulation
+		float projection_target;
 
 		ofTrueTypeFont font, legend_font;
+		std::string intro_text;
+		TextMeshCache intro_text_cache, hud_text_cache; // see draw()
 
 		// SOUND
-		ofSoundPlayer chatting_sound_en;
-		ofSoundPlayer chatting_sound_jp;
-		ofSoundPlayer chatting_sound_es;
-		ofSoundPlayer chatting_sound_fr;
-		ofSoundPlayer chatting_sound_it;
-		ofSoundPlayer chatting_sound_gr;
-		ofSoundPlayer chatting_sound_de;
-		ofSoundPlayer thanks_sound;
+		// all samples live in memory and are mixed on the audio thread (see VoiceMixer)
+		ofSoundStream sound_stream;
+		VoiceMixer mixer;
+		int chatting_sound_en;
+		int chatting_sound_jp;
+		int chatting_sound_es;
+		int chatting_sound_fr;
+		int chatting_sound_it;
+		int chatting_sound_gr;
+		int chatting_sound_de;
+		int thanks_sound;
 
 		// INTERNET ARTWORK
 		SandLine sand_line;
 		bool save_artwork;
 
+		// PROFILING
+		FrameProfiler profiler;
+		int phase_tweets, phase_sand_line, phase_camera;
+		int phase_density, phase_hashtags, phase_reproject, phase_history, phase_map_draw, phase_labels, phase_text_draw, phase_composite;
+		FrameProfiler sim_profiler; // written only by the simulation thread, a "frame" is a tick
+		int phase_sim_osc, phase_sim_tweets, phase_sim_fireworks, phase_sim_camera;
+
+		// TASKS
+		// the independent phases of update(), and the big loops, spread on all the cores
+		TaskScheduler scheduler;
+		TaskGraph frame_graph;
+		float tasks_serial_ms, tasks_wall_ms, tasks_overhead_ms; // summed over a second
+		int tasks_frames;
+		std::string tasks_view; // for the hud
+		float last_tasks_view_time;
+
+		// AUTOSAVE
+		TileAutosave autosave;
+		float autosave_interval; // seconds
+		float last_autosave_time;
+
+		// TIME-LAPSE
+		// the artwork of each visitor growing, 't' turns it on and off
+		TimelapseRecorder timelapse;
+		bool timelapse_enabled;
+		void log_timelapse();
+
+		// QUALITY
+		// what's drawn gets cheaper when the frames are too slow (see QualityGovernor)
+		QualityGovernor governor;
+		uint64_t frame_start_time; // micros, the start of update()
+		std::atomic <int> max_fireworks; // read by the simulation
+		void apply_quality();
+
+		// METRICS
+		// prometheus text on localhost and in a file, for watching the fleet (see vv_metrics)
+		MetricsServer metrics_server;
+
+		// MEMORY
+		float memory_log_interval; // seconds
+		float last_memory_log_time;
+
 	// ARDUINO METHODS
 	private:
     
@@ -1,5 +1,8 @@
 #include "vv_extrude_font.h"
 
+// ofPath shares one tessellator between all its instances (getOutline() and getTessellation() use it):
+// text can be extruded from any thread, but one at a time
+static std::recursive_mutex tessellator_mutex;
 
 //--------------------------------------------------------------
 // Original credits go to jefftimeisten, see https://forum.openframeworks.cc/t/extrude-text-into-3d/6938
@@ -26,6 +29,8 @@
 //--------------------------------------------------------------
 vector<ofMesh> extrude_mesh_from_text(string word, ofTrueTypeFont & font, float extrusion_depth, float scale=1, bool get_front_only=false){
 
+    std::unique_lock<std::recursive_mutex> lock(tessellator_mutex);
+
     // replace spaces with underscores
     std::replace(word.begin(), word.end(), ' ', '_');
 
@@ -149,6 +154,8 @@ vector<ofMesh> extrude_mesh_from_text(string word, ofTrueTypeFont & font, float
 //--------------------------------------------------------------
 vector <ofPath> get_string_as_sampled_points(ofTrueTypeFont & font, string s, int num_of_samples){
 
+    std::unique_lock<std::recursive_mutex> lock(tessellator_mutex);
+
     vector <ofPath> string_paths;
     vector <ofTTFCharacter> paths = font.getStringAsPoints(s);
 
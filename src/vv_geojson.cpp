@@ -2,6 +2,35 @@
 
 using namespace vv_map_projections;
 
+namespace {
+
+    //--------------------------------------------------------------
+    // rough size of a parsed json tree: every value plus its slot in the
+    // parent container, and the characters of the strings
+    //--------------------------------------------------------------
+    int64_t estimate_json_bytes(const Json::Value & value){
+
+        int64_t bytes = sizeof(Json::Value);
+
+        if (value.isString()){
+            bytes += value.asString().size();
+        }
+        else if (value.isArray()){
+            for (Json::ArrayIndex i = 0; i < value.size(); i++){
+                bytes += estimate_json_bytes(value[i]) + 4 * sizeof(void *);
+            }
+        }
+        else if (value.isObject()){
+            Json::Value::Members members = value.getMemberNames();
+            for (int m = 0; m < members.size(); m++){
+                bytes += estimate_json_bytes(value[members[m]]) + 4 * sizeof(void *) + members[m].size();
+            }
+        }
+
+        return bytes;
+    }
+}
+
 //--------------------------------------------------------------
 // @short:  loads the geojson map and fills the given vectors of ofVboMeshes.
 // @desc:   currently supports the loading of Point, Polygon and MultiPolygon geojson feature types.
@@ -13,18 +42,30 @@ using namespace vv_map_projections;
 //          poly_meshes: a vector of ofVboMeshes that will be filled with polygonal contours
 //          cities_meshes: a vector of City structs which host the meshes for the extruded cities names
 //          scale: used to uniformly change the size of the mesh
+//          store: if given, also gets the unprojected coordinates of the rings and the cities (see GeoStore)
+//          countries: if given, gets the projected rings of every country, holes included (see CountryFill)
+//          outlines: false leaves poly_meshes empty, for when the outlines are streamed from a tile pyramid
 // @return: the centroid of the mesh created from the geojson
 //--------------------------------------------------------------
-ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font, vector<ofMesh> & poly_meshes, vector<City> & cities_meshes, float scale){
+ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font, vector<ofMesh> & poly_meshes, vector<City> & cities_meshes, float scale, GeoStore * store, vector<Country> * countries, bool outlines){
 
     // std::string path = "world_cities_countries.geojson";
+    vv_trace::Span map_span("create_geojson_map");
+
     ofMesh poly_meshes_centroids;
     ofPoint geoshape_centroid = ofPoint(0, 0, 0);
 
     ofxJSONElement geojson_map;
 
     // Parse the JSON
+    vv_trace::begin("json parse");
     bool parsing_successful = geojson_map.open(path);
+    vv_trace::end();
+
+    {
+        vv_trace::Span span("json accounting");
+        vv_memory::set(vv_memory::JSON_DOM, estimate_json_bytes(geojson_map));
+    }
 
     if (parsing_successful){
         cout << "File " << path << " loaded correctly" << endl;
@@ -43,6 +84,9 @@ ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font,
         // currently supported: Point, Polygon, MultiPolygon
         std::string type  = geojson_map["features"][i]["geometry"]["type"].asString();
 
+        // one span per feature, named after its type
+        vv_trace::Span feature_span(type.empty() ? "empty feature" : type);
+
         if (type == "Point"){
             float lon = coordinates[0].asFloat();
             float lat = coordinates[1].asFloat();
@@ -61,8 +105,12 @@ ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font,
             // excluding some cities for aesthetic reasons
             if (city_name != "#vatican city"){
 
+                vv_trace::begin("label extrusion");
                 vector<ofMesh> city_name_meshes = extrude_mesh_from_text(city_name, font, 2, 0.012, true);
+                vv_trace::end();
                 
+                if (store) store->add_point(lon, lat);
+
                 City current_city;
                 current_city.meshes = city_name_meshes;
                 current_city.position = projected;
@@ -71,12 +119,42 @@ ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font,
 
             }
         }
-        else if (type == "Polygon"){
+        // the outlines only need the outer rings, the filled countries need the holes too
+        if (countries && (type == "Polygon" || type == "MultiPolygon")){
+
+            Country country;
+            country.name = geojson_map["features"][i]["properties"]["NAME"].asString();
+            country.long_name = geojson_map["features"][i]["properties"]["NAME_LONG"].asString();
+            country.sovereignty = geojson_map["features"][i]["properties"]["SOVEREIGNT"].asString();
+
+            // a Polygon is a MultiPolygon with a single polygon
+            int n_polygons = type == "Polygon" ? 1 : coordinates.size();
+            for (Json::ArrayIndex k = 0; k < n_polygons; ++k){
+
+                const Json::Value & rings = type == "Polygon" ? coordinates : coordinates[k];
+                vector <ofPolyline> polygon;
+
+                for (Json::ArrayIndex r = 0; r < rings.size(); ++r){
+                    ofPolyline ring;
+                    for (Json::ArrayIndex j = 0; j < rings[r].size(); ++j){
+                        ring.addVertex(mercator(rings[r][j][0].asFloat(), rings[r][j][1].asFloat(), scale));
+                    }
+                    ring.close();
+                    polygon.push_back(ring);
+                }
+                country.polygons.push_back(polygon);
+            }
+            countries->push_back(country);
+        }
+
+        if (type == "Polygon"){
 
             // we need to start a new ofMesh
             ofMesh mesh;
+            ofPoint ring_sum; // for the centroid, with or without the mesh
 
             int n_points = coordinates[0].size();
+            if (store) store->begin_ring();
 
             //cout << "current i: " << i << ", type: " << type << ", n_points: " << n_points << endl;
 
@@ -86,17 +164,20 @@ ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font,
                 float lat = coordinates[0][j][1].asFloat();
 
                 //cout << "current point, float: "<< lon << ", " << lat << endl;
+                if (store) store->add_vertex(lon, lat);
 
                 ofPoint projected = mercator(lon, lat, scale);
                 //cout << "current point after projection: "<< ofToString(projected) << endl;
+                ring_sum += projected;
 
+                if (!outlines) continue;
                 mesh.addVertex(projected);
                 mesh.addColor(ofFloatColor(0.0));
             }
             mesh.setMode(OF_PRIMITIVE_LINE_STRIP);
-            poly_meshes.push_back(mesh);
+            if (outlines) poly_meshes.push_back(mesh);
 
-            ofPoint mesh_centroid = mesh.getCentroid();
+            ofPoint mesh_centroid = n_points > 0 ? ring_sum / n_points : ofPoint(0, 0, 0);
 
             poly_meshes_centroids.addVertex(mesh_centroid);
             poly_meshes_centroids.addColor(ofFloatColor(1.0, 0.0, 0.0));
@@ -112,25 +193,30 @@ ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font,
             for (Json::ArrayIndex k = 0; k < n_polygons; ++k){
                 
                 ofMesh mesh;
+                ofPoint ring_sum;
 
                 int n_points = coordinates[k][0].size();
+                if (store) store->begin_ring();
 
                 for (Json::ArrayIndex j = 0; j < n_points; ++j){
                     float lon = coordinates[k][0][j][0].asFloat();
                     float lat = coordinates[k][0][j][1].asFloat();
+                    if (store) store->add_vertex(lon, lat);
 
                     ofPoint projected = mercator(lon, lat, scale);
                     //cout << "current point after projection: "<< ofToString(projected) << endl;
-                    
+                    ring_sum += projected;
+
+                    if (!outlines) continue;
                     mesh.addVertex(projected);
                     mesh.addColor(ofFloatColor(0.0));
                     mesh.addIndex(j);
                 }
                 mesh.setMode(OF_PRIMITIVE_LINE_STRIP);
                 // mesh.setMode(OF_PRIMITIVE_POINTS);
-                poly_meshes.push_back(mesh);
+                if (outlines) poly_meshes.push_back(mesh);
 
-                ofPoint mesh_centroid = mesh.getCentroid();
+                ofPoint mesh_centroid = n_points > 0 ? ring_sum / n_points : ofPoint(0, 0, 0);
 
                 poly_meshes_centroids.addVertex(mesh_centroid);
                 poly_meshes_centroids.addColor(ofFloatColor(0.0, 0.0, 1.0));
@@ -145,6 +231,22 @@ ofPoint vv_geojson::create_geojson_map(std::string path, ofTrueTypeFont & font,
     // set the overall geoshape centroid
     // making an average of the centroids
     geoshape_centroid /= poly_meshes_centroids.getNumVertices();
+
+    // the meshes are handed to the caller, the json goes away with this function
+    int64_t poly_bytes = 0;
+    for (int m = 0; m < poly_meshes.size(); m++){
+        poly_bytes += vv_memory::get_mesh_bytes(poly_meshes[m]);
+    }
+    vv_memory::set(vv_memory::MAP_MESHES, poly_bytes);
+
+    int64_t label_bytes = 0;
+    for (int c = 0; c < cities_meshes.size(); c++){
+        for (int m = 0; m < cities_meshes[c].meshes.size(); m++){
+            label_bytes += vv_memory::get_mesh_bytes(cities_meshes[c].meshes[m]);
+        }
+    }
+    vv_memory::set(vv_memory::LABEL_MESHES, label_bytes);
+    vv_memory::set(vv_memory::JSON_DOM, 0);
     
     return geoshape_centroid;
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
+#pragma once
 #include "ofMain.h"
 #include "ofxJSON.h"
 #include "vv_extrude_font.h"
 #include "vv_map_projections.h"
+#include "vv_trace.h"
+#include "vv_memory.h"
+#include "GeoStore.h"
 #include <regex>
 
 namespace vv_geojson {
@@ -12,6 +16,11 @@ namespace vv_geojson {
         ofPoint position;
     };
 
-    ofPoint create_geojson_map(std::string path, ofTrueTypeFont & font, vector<ofMesh> & poly_meshes, vector<City> & cities_meshes,  float scale);
+    struct Country {
+        std::string name, long_name, sovereignty; // NAME, NAME_LONG and SOVEREIGNT in the geojson
+        vector <vector<ofPolyline> > polygons; // the rings of each polygon, the outer one first (holes included)
+    };
+
+    ofPoint create_geojson_map(std::string path, ofTrueTypeFont & font, vector<ofMesh> & poly_meshes, vector<City> & cities_meshes,  float scale, GeoStore * store = NULL, vector<Country> * countries = NULL, bool outlines = true);
 
 }
\ No newline at end of file
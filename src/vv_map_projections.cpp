@@ -18,17 +18,41 @@ ofPoint vv_map_projections::spherical_to_cartesian(float lon, float lat, float r
 
 //--------------------------------------------------------------
 // taken and edited from the ofxGeoJSON addon by moxuse
+// @args:   scale: half the width of the map, the equator goes from -scale to scale
+//          (this used to be ignored in favour of WIDTH / (2 * PI), see ofApp::setup())
 //--------------------------------------------------------------
 ofPoint vv_map_projections::mercator(float lon, float lat, float scale){
-    
-    ofVec2f offset = ofVec2f(WIDTH / 2, HEIGHT / 2);
-
-    scale = WIDTH / (2 * PI);
 
     ofPoint position;
 
-    position.x = (lon / 180) * scale - 0;
+    position.x = (lon / 180) * scale;
     // this is pure black magic I don't know anything about it
-    position.y = (log(tan(PI / 4.0 + ofDegToRad(lat) / 2.0)) / PI) * scale - 0;
+    position.y = (log(tan(PI / 4.0 + ofDegToRad(lat) / 2.0)) / PI) * scale;
+    return position;
+}
+
+//--------------------------------------------------------------
+ofVec2f vv_map_projections::inverse_mercator(ofPoint position, float scale){
+
+    float lon = position.x / scale * 180;
+    float lat = ofRadToDeg(2 * atan(exp(position.y / scale * PI)) - PI / 2.0);
+    return ofVec2f(lon, lat);
+}
+
+//--------------------------------------------------------------
+// @desc:   a sphere with the same equator length of mercator() at the same scale.
+//          lon 0, lat 0 touches the map plane at the origin and faces +z (the camera),
+//          so that near that point the two projections match and can be blended.
+//--------------------------------------------------------------
+ofPoint vv_map_projections::globe(float lon, float lat, float scale){
+
+    float radius = scale / PI;
+    float longitude = ofDegToRad(lon);
+    float latitude = ofDegToRad(lat);
+
+    ofPoint position;
+    position.x = radius * cos(latitude) * sin(longitude);
+    position.y = radius * sin(latitude);
+    position.z = radius * (cos(latitude) * cos(longitude) - 1);
     return position;
-}
\ No newline at end of file
+}
@@ -6,4 +6,6 @@ namespace vv_map_projections {
     
     ofPoint spherical_to_cartesian(float lon, float lat, float radius);
     ofPoint mercator(float lon, float lat, float scale);
-}
\ No newline at end of file
+    ofVec2f inverse_mercator(ofPoint position, float scale); // returns lon, lat
+    ofPoint globe(float lon, float lat, float scale);
+}
@@ -0,0 +1,170 @@
+#include "vv_memory.h"
+#include <iomanip>
+
+namespace {
+
+    std::atomic <int64_t> current_bytes[vv_memory::NUM_SUBSYSTEMS];
+    std::atomic <int64_t> peak_bytes[vv_memory::NUM_SUBSYSTEMS];
+
+    const char * names[vv_memory::NUM_SUBSYSTEMS] = {
+        "map meshes",
+        "map geometry",
+        "map tiles",
+        "label meshes",
+        "label geometry",
+        "json dom",
+        "sand grains",
+        "firework particles",
+        "sound buffers",
+        "density",
+        "hashtags",
+        "geo store",
+        "country fill",
+        "country locator",
+        "tweet history",
+        "trends",
+        "timelapse",
+        "map reload"
+    };
+
+    thread_local vv_memory::Staging * current_staging = NULL;
+
+    void update_peak(int subsystem, int64_t bytes){
+        int64_t peak = peak_bytes[subsystem].load();
+        while (bytes > peak && !peak_bytes[subsystem].compare_exchange_weak(peak, bytes)){}
+    }
+}
+
+//--------------------------------------------------------------
+void vv_memory::add(int subsystem, int64_t bytes){
+    if (current_staging != NULL){
+        current_staging->stage(subsystem, current_staging->_bytes[subsystem] + bytes);
+        return;
+    }
+    int64_t now = current_bytes[subsystem].fetch_add(bytes) + bytes;
+    update_peak(subsystem, now);
+}
+
+//--------------------------------------------------------------
+void vv_memory::set(int subsystem, int64_t bytes){
+    if (current_staging != NULL){
+        current_staging->stage(subsystem, bytes);
+        return;
+    }
+    current_bytes[subsystem].store(bytes);
+    update_peak(subsystem, bytes);
+}
+
+//--------------------------------------------------------------
+int64_t vv_memory::get_current(int subsystem){
+    return current_bytes[subsystem].load();
+}
+
+//--------------------------------------------------------------
+int64_t vv_memory::get_peak(int subsystem){
+    return peak_bytes[subsystem].load();
+}
+
+//--------------------------------------------------------------
+int64_t vv_memory::get_total(){
+    int64_t total = 0;
+    for (int s = 0; s < NUM_SUBSYSTEMS; s++) total += current_bytes[s].load();
+    return total;
+}
+
+//--------------------------------------------------------------
+int64_t vv_memory::get_mesh_bytes(const ofMesh & mesh){
+    return mesh.getNumVertices() * sizeof(ofVec3f) + 
+        mesh.getNumColors() * sizeof(ofFloatColor) + 
+        mesh.getNumNormals() * sizeof(ofVec3f) + 
+        mesh.getNumTexCoords() * sizeof(ofVec2f) + 
+        mesh.getNumIndices() * sizeof(ofIndexType);
+}
+
+//--------------------------------------------------------------
+const char * vv_memory::get_name(int subsystem){
+    return names[subsystem];
+}
+
+//--------------------------------------------------------------
+std::string vv_memory::get_report(){
+
+    std::stringstream report;
+    report << "memory (KB)          current       peak" << endl;
+    for (int s = 0; s < NUM_SUBSYSTEMS; s++){
+        report << std::left << std::setw(20) << names[s];
+        report << std::right << std::setw(10) << get_current(s) / 1024;
+        report << std::setw(11) << get_peak(s) / 1024 << endl;
+    }
+    report << std::left << std::setw(20) << "total" << std::right << std::setw(10) << get_total() / 1024 << endl;
+    return report.str();
+}
+
+//--------------------------------------------------------------
+// e.g. "memory KB: map meshes 0/1060, map geometry 145/145, ..."
+//--------------------------------------------------------------
+std::string vv_memory::get_log_line(){
+
+    std::stringstream line;
+    line << "memory KB (current/peak): ";
+    for (int s = 0; s < NUM_SUBSYSTEMS; s++){
+        line << names[s] << " " << get_current(s) / 1024 << "/" << get_peak(s) / 1024 << ", ";
+    }
+    line << "total " << get_total() / 1024;
+    return line.str();
+}
+
+//--------------------------------------------------------------
+// STAGING
+//--------------------------------------------------------------
+vv_memory::Staging::Staging(int subsystem){
+    _subsystem = subsystem;
+    for (int s = 0; s < NUM_SUBSYSTEMS; s++){
+        _bytes[s] = 0;
+        _touched[s] = false;
+    }
+}
+
+//--------------------------------------------------------------
+vv_memory::Staging::~Staging(){
+    if (current_staging == this) end();
+    int64_t total = 0;
+    for (int s = 0; s < NUM_SUBSYSTEMS; s++) total += _bytes[s];
+    add(_subsystem, -total);
+}
+
+//--------------------------------------------------------------
+void vv_memory::Staging::begin(){
+    current_staging = this;
+}
+
+//--------------------------------------------------------------
+void vv_memory::Staging::end(){
+    current_staging = NULL;
+}
+
+//--------------------------------------------------------------
+void vv_memory::Staging::commit(){
+
+    if (current_staging == this) end();
+    int64_t total = 0;
+    for (int s = 0; s < NUM_SUBSYSTEMS; s++){
+        if (_touched[s]) set(s, _bytes[s]);
+        total += _bytes[s];
+        _bytes[s] = 0;
+        _touched[s] = false;
+    }
+    add(_subsystem, -total);
+}
+
+//--------------------------------------------------------------
+void vv_memory::Staging::stage(int subsystem, int64_t bytes){
+
+    Staging * staging = current_staging;
+    current_staging = NULL; // the total goes to the real counter
+    add(_subsystem, bytes - _bytes[subsystem]);
+    current_staging = staging;
+
+    _bytes[subsystem] = bytes;
+    _touched[subsystem] = true;
+}
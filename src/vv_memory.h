@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+
+//--------------------------------------------------------------
+// Current and peak bytes used by each subsystem, to size the ram of the
+// kiosk and to catch slow growth over days of running.
+// Containers that grow during the installation use a CountingAllocator,
+// the rest is reported with explicit set()/add() calls where it's built or released.
+// Counters are atomic, they can be touched from any thread.
+// Something built in the background to replace what's running (a reloaded
+// map) counts under a Staging until it takes its place, so it doesn't
+// overwrite the numbers of the live one.
+//
+// @example:
+//
+// deque <Grain, vv_memory::CountingAllocator<Grain, vv_memory::SAND_GRAINS> > sand_grains;
+// vv_memory::set(vv_memory::SOUND_BUFFERS, mixer.get_bytes());
+// cout << vv_memory::get_report() << endl;
+//--------------------------------------------------------------
+
+namespace vv_memory {
+
+    enum Subsystem {
+        MAP_MESHES, // poly_meshes, as loaded from the geojson
+        MAP_GEOMETRY, // the quantized outlines
+        MAP_TILES, // streamed outlines (TileStreamer)
+        LABEL_MESHES, // extruded city names, as loaded
+        LABEL_GEOMETRY, // the quantized city names
+        JSON_DOM, // the parsed geojson
+        SAND_GRAINS,
+        FIREWORK_PARTICLES,
+        SOUND_BUFFERS,
+        DENSITY,
+        HASHTAGS, // the extruded ones floating over the map
+        GEO_STORE, // unprojected coordinates, for the globe
+        COUNTRY_FILL, // tessellated countries
+        COUNTRY_LOCATOR, // the grid of the countries, for the tweets with coordinates
+        TWEET_HISTORY, // on the heap, not what was spilled to disk
+        TRENDS, // sketches of the trending hashtags and cities, fixed
+        TIMELAPSE, // frames between the artwork fbo and the disk
+        MAP_RELOAD, // a map built in the background, until it's swapped in (see Staging)
+        NUM_SUBSYSTEMS
+    };
+
+    void add(int subsystem, int64_t bytes); // bytes can be negative
+    void set(int subsystem, int64_t bytes);
+
+    int64_t get_current(int subsystem);
+    int64_t get_peak(int subsystem);
+    int64_t get_total(); // current bytes of all the subsystems
+    const char * get_name(int subsystem);
+    int64_t get_mesh_bytes(const ofMesh & mesh); // vertex attributes and indices
+
+    std::string get_report(); // one line per subsystem
+    std::string get_log_line(); // everything on one line, in KB
+
+    //--------------------------------------------------------------
+    // between begin() and end(), set() and add() on this thread are kept
+    // here and summed under one subsystem; commit() moves them where they
+    // belong, dropping a staging that wasn't committed gives them back
+    //--------------------------------------------------------------
+    class Staging {
+
+        public:
+
+            Staging(int subsystem);
+            ~Staging();
+
+            void begin();
+            void end();
+            void commit(); // set() of every subsystem touched, once the live one is replaced
+
+        private:
+
+            friend void add(int subsystem, int64_t bytes);
+            friend void set(int subsystem, int64_t bytes);
+
+            void stage(int subsystem, int64_t bytes); // the new value of subsystem
+
+            int _subsystem;
+            int64_t _bytes[NUM_SUBSYSTEMS];
+            bool _touched[NUM_SUBSYSTEMS];
+    };
+
+    //--------------------------------------------------------------
+    // std allocator that counts its bytes under a subsystem
+    //--------------------------------------------------------------
+    template <class T, int SUBSYSTEM>
+    class CountingAllocator {
+
+        public:
+
+            typedef T value_type;
+
+            template <class U>
+            struct rebind {
+                typedef CountingAllocator<U, SUBSYSTEM> other;
+            };
+
+            CountingAllocator(){}
+            template <class U>
+            CountingAllocator(const CountingAllocator<U, SUBSYSTEM> &){}
+
+            T * allocate(std::size_t n){
+                add(SUBSYSTEM, n * sizeof(T));
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T * p, std::size_t n){
+                add(SUBSYSTEM, -int64_t(n * sizeof(T)));
+                ::operator delete(p);
+            }
+    };
+
+    template <class T, class U, int SUBSYSTEM>
+    bool operator==(const CountingAllocator<T, SUBSYSTEM> &, const CountingAllocator<U, SUBSYSTEM> &){ return true; }
+    template <class T, class U, int SUBSYSTEM>
+    bool operator!=(const CountingAllocator<T, SUBSYSTEM> &, const CountingAllocator<U, SUBSYSTEM> &){ return false; }
+}
@@ -0,0 +1,112 @@
+#include "vv_metrics.h"
+
+namespace {
+
+    // upper bounds of the buckets, in ms: the frame budget is 22.2 at 45 fps
+    const int NUM_BUCKETS = 9;
+    const double bucket_bounds[NUM_BUCKETS] = {2, 5, 10, 16.7, 22.2, 33.3, 50, 100, 250};
+
+    std::atomic <uint64_t> counters[vv_metrics::NUM_COUNTERS];
+    std::atomic <double> gauges[vv_metrics::NUM_GAUGES];
+    std::atomic <uint64_t> buckets[vv_metrics::NUM_HISTOGRAMS][NUM_BUCKETS + 1]; // the last one is +Inf
+    std::atomic <uint64_t> sums[vv_metrics::NUM_HISTOGRAMS]; // in microseconds, so it can be added to
+
+    const char * counter_names[vv_metrics::NUM_COUNTERS][2] = {
+        {"maypop_tweets_received_total", "tweets heard over osc"},
+        {"maypop_tweets_processed_total", "tweets applied to the map and the artwork"},
+        {"maypop_tweets_dropped_total", "tweets that arrived while the map was loading"},
+        {"maypop_city_misses_total", "tweets with neither coordinates nor a known city"},
+        {"maypop_sim_ticks_dropped_total", "simulation ticks skipped to catch up"}
+    };
+
+    const char * gauge_names[vv_metrics::NUM_GAUGES][2] = {
+        {"maypop_fireworks", "fireworks alive"},
+        {"maypop_firework_particles", "particles of the fireworks alive"},
+        {"maypop_sand_grains", "grains of sand waiting to be drawn"},
+        {"maypop_fps", "frames per second"},
+        {"maypop_quality_level", "quality level chosen by the governor, 0 is the best"}
+    };
+
+    const char * histogram_names[vv_metrics::NUM_HISTOGRAMS][2] = {
+        {"maypop_frame_ms", "time between two frames"},
+        {"maypop_sim_step_ms", "time of a simulation tick"}
+    };
+
+    void write_header(std::stringstream & out, const char * name, const char * help, const char * type){
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+    }
+}
+
+//--------------------------------------------------------------
+void vv_metrics::increment(int counter, uint64_t n){
+    counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+void vv_metrics::set(int gauge, double value){
+    gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+// @desc:   counts the value in the first bucket it fits in, the cumulative
+//          counts prometheus wants are summed when read
+//--------------------------------------------------------------
+void vv_metrics::observe(int histogram, double value){
+
+    int bucket = 0;
+    while (bucket < NUM_BUCKETS && value > bucket_bounds[bucket]) bucket++;
+    buckets[histogram][bucket].fetch_add(1, std::memory_order_relaxed);
+    sums[histogram].fetch_add(uint64_t(std::max(0.0, value) * 1000), std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+uint64_t vv_metrics::get_counter(int counter){
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+double vv_metrics::get_gauge(int gauge){
+    return gauges[gauge].load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+// @return: everything in the prometheus text format (version 0.0.4)
+//--------------------------------------------------------------
+std::string vv_metrics::get_prometheus_text(){
+
+    std::stringstream out;
+
+    for (int c = 0; c < NUM_COUNTERS; c++){
+        write_header(out, counter_names[c][0], counter_names[c][1], "counter");
+        out << counter_names[c][0] << " " << get_counter(c) << "\n";
+    }
+
+    for (int g = 0; g < NUM_GAUGES; g++){
+        write_header(out, gauge_names[g][0], gauge_names[g][1], "gauge");
+        out << gauge_names[g][0] << " " << get_gauge(g) << "\n";
+    }
+
+    for (int h = 0; h < NUM_HISTOGRAMS; h++){
+        const char * name = histogram_names[h][0];
+        write_header(out, name, histogram_names[h][1], "histogram");
+        uint64_t count = 0;
+        for (int b = 0; b <= NUM_BUCKETS; b++){
+            count += buckets[h][b].load(std::memory_order_relaxed);
+            out << name << "_bucket{le=\"" << (b < NUM_BUCKETS ? ofToString(bucket_bounds[b]) : "+Inf") << "\"} " << count << "\n";
+        }
+        out << name << "_sum " << sums[h].load(std::memory_order_relaxed) / 1000.0 << "\n";
+        out << name << "_count " << count << "\n";
+    }
+
+    write_header(out, "maypop_memory_bytes", "current bytes of each subsystem (see vv_memory)", "gauge");
+    for (int s = 0; s < vv_memory::NUM_SUBSYSTEMS; s++){
+        out << "maypop_memory_bytes{subsystem=\"" << vv_memory::get_name(s) << "\"} " << vv_memory::get_current(s) << "\n";
+    }
+    write_header(out, "maypop_memory_peak_bytes", "peak bytes of each subsystem", "gauge");
+    for (int s = 0; s < vv_memory::NUM_SUBSYSTEMS; s++){
+        out << "maypop_memory_peak_bytes{subsystem=\"" << vv_memory::get_name(s) << "\"} " << vv_memory::get_peak(s) << "\n";
+    }
+
+    return out.str();
+}
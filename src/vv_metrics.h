@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"
+#include "vv_memory.h"
+#include <atomic>
+
+//--------------------------------------------------------------
+// Counters, gauges and histograms of the health of the installation, read
+// from outside by MetricsServer as prometheus text.
+// Everything is a relaxed atomic in a fixed array: recording is a single
+// add or store from any thread, never a lock or an allocation, and the
+// reader may see a histogram a few observations ahead of its count.
+//
+// @example:
+//
+// vv_metrics::increment(vv_metrics::TWEETS_RECEIVED);
+// vv_metrics::set(vv_metrics::SAND_GRAINS, sand_grains.size());
+// vv_metrics::observe(vv_metrics::FRAME_MS, ofGetLastFrameTime() * 1000);
+// cout << vv_metrics::get_prometheus_text();
+//--------------------------------------------------------------
+
+namespace vv_metrics {
+
+    enum Counter {
+        TWEETS_RECEIVED, // from the osc messages
+        TWEETS_PROCESSED, // applied on the main thread
+        TWEETS_DROPPED, // arrived while loading
+        CITY_MISSES, // neither coordinates nor a city we know
+        SIM_TICKS_DROPPED, // the simulation was too far behind
+        NUM_COUNTERS
+    };
+
+    enum Gauge {
+        FIREWORKS,
+        FIREWORK_PARTICLES,
+        SAND_GRAINS, // waiting to be drawn
+        FPS,
+        QUALITY_LEVEL, // of the QualityGovernor, 0 is the best
+        NUM_GAUGES
+    };
+
+    enum Histogram {
+        FRAME_MS,
+        SIM_STEP_MS,
+        NUM_HISTOGRAMS
+    };
+
+    void increment(int counter, uint64_t n = 1);
+    void set(int gauge, double value);
+    void observe(int histogram, double value);
+
+    uint64_t get_counter(int counter);
+    double get_gauge(int gauge);
+
+    std::string get_prometheus_text(); // the memory of vv_memory included
+}
@@ -0,0 +1,259 @@
+#include "vv_tile_pyramid.h"
+
+using namespace vv_map_projections;
+
+namespace {
+
+    //--------------------------------------------------------------
+    // Liang-Barsky: the part of the segment a-b inside rect, as a range of
+    // its parameter
+    // @return: false if no part of it is inside
+    //--------------------------------------------------------------
+    bool clip_segment(const ofPoint & a, const ofPoint & b, const ofRectangle & rect, float & t_0, float & t_1){
+
+        float d_x = b.x - a.x;
+        float d_y = b.y - a.y;
+        float p[4] = {-d_x, d_x, -d_y, d_y};
+        float q[4] = {a.x - rect.getLeft(), rect.getRight() - a.x, a.y - rect.getTop(), rect.getBottom() - a.y};
+
+        t_0 = 0;
+        t_1 = 1;
+        for (int i = 0; i < 4; i++){
+            if (p[i] == 0){
+                if (q[i] < 0) return false; // parallel to this side, and outside of it
+                continue;
+            }
+            float t = q[i] / p[i];
+            if (p[i] < 0) t_0 = std::max(t_0, t);
+            else t_1 = std::min(t_1, t);
+            if (t_0 > t_1) return false;
+        }
+        return true;
+    }
+
+    //--------------------------------------------------------------
+    // cuts the ring in the line strips that fall inside rect: a new strip
+    // starts every time the ring comes back in
+    //--------------------------------------------------------------
+    void clip_ring(const vector<ofPoint> & ring, const ofRectangle & rect, vector<vector<ofPoint> > & strips){
+
+        vector <ofPoint> strip;
+
+        for (int i = 0; i + 1 < ring.size(); i++){
+
+            float t_0, t_1;
+            if (!clip_segment(ring[i], ring[i + 1], rect, t_0, t_1)){
+                if (strip.size() > 1) strips.push_back(strip);
+                strip.clear();
+                continue;
+            }
+
+            ofPoint direction = ring[i + 1] - ring[i];
+            if (strip.empty()) strip.push_back(ring[i] + direction * t_0);
+            strip.push_back(ring[i] + direction * t_1);
+
+            // going out: whatever comes next is a new strip
+            if (t_1 < 1){
+                if (strip.size() > 1) strips.push_back(strip);
+                strip.clear();
+            }
+        }
+        if (strip.size() > 1) strips.push_back(strip);
+    }
+}
+
+//--------------------------------------------------------------
+// @short:  cuts the Polygon/MultiPolygon features of a geojson file in a tile pyramid.
+// @desc:   this is the offline step, run it with "--build-tiles" (see main.cpp).
+//          Every ring is simplified with a tolerance of 1/256 of the tile size
+//          and clipped to each tile its bounding box overlaps: a tile only
+//          holds the line strips inside it, the neighbours meet on the border.
+// @args:   geojson_path: the geojson file, relative to bin/data
+//          directory: where to write the pyramid, relative to bin/data
+//          max_zoom: deepest zoom level
+//          scale: same scale given to create_geojson_map()
+// @return: false if the file couldn't be parsed
+//--------------------------------------------------------------
+bool vv_tile_pyramid::build(std::string geojson_path, std::string directory, int max_zoom, float scale){
+
+    ofxJSONElement geojson_map;
+    if (!geojson_map.open(geojson_path)){
+        cout << "vv_tile_pyramid::build: failed to parse " << geojson_path << endl;
+        return false;
+    }
+
+    // 1. project all the rings
+    vector <ofPolyline> rings;
+    ofRectangle bounds;
+    bool first_point = true;
+
+    for (Json::ArrayIndex i = 0; i < geojson_map["features"].size(); ++i){
+
+        ofxJSONElement coordinates = geojson_map["features"][i]["geometry"]["coordinates"];
+        std::string type  = geojson_map["features"][i]["geometry"]["type"].asString();
+
+        int n_polygons = 0;
+        if (type == "Polygon") n_polygons = 1;
+        else if (type == "MultiPolygon") n_polygons = coordinates.size();
+
+        for (Json::ArrayIndex k = 0; k < n_polygons; ++k){
+
+            // only the outer ring, like create_geojson_map()
+            Json::Value ring_coordinates = type == "Polygon" ? coordinates[0] : coordinates[k][0];
+
+            ofPolyline ring;
+            for (Json::ArrayIndex j = 0; j < ring_coordinates.size(); ++j){
+                ofPoint projected = mercator(ring_coordinates[j][0].asFloat(), ring_coordinates[j][1].asFloat(), scale);
+                ring.addVertex(projected);
+
+                if (first_point){
+                    bounds = ofRectangle(projected.x, projected.y, 0, 0);
+                    first_point = false;
+                }
+                else {
+                    bounds.growToInclude(projected.x, projected.y);
+                }
+            }
+            if (ring.size() > 1) rings.push_back(ring);
+        }
+    }
+
+    cout << "vv_tile_pyramid::build: " << rings.size() << " rings" << endl;
+
+    ofDirectory::createDirectory(directory, true, true);
+
+    // 2. every zoom level
+    for (int z = 0; z <= max_zoom; z++){
+
+        int n_tiles = 1 << z;
+        float tile_w = bounds.getWidth() / n_tiles;
+        float tile_h = bounds.getHeight() / n_tiles;
+        float tolerance = std::max(tile_w, tile_h) / 256.0f;
+
+        ofDirectory::createDirectory(directory + "/" + ofToString(z), true, true);
+
+        std::map <TileKey, vector<vector<ofPoint> > > tiles; // the clipped strips of each tile
+
+        for (int r = 0; r < rings.size(); r++){
+
+            ofPolyline simplified = rings[r];
+            simplified.simplify(tolerance);
+            if (simplified.size() < 2) continue;
+
+            ofRectangle ring_bounds = rings[r].getBoundingBox();
+            int x_1 = ofClamp(floor((ring_bounds.getLeft() - bounds.x) / tile_w), 0, n_tiles - 1);
+            int x_2 = ofClamp(floor((ring_bounds.getRight() - bounds.x) / tile_w), 0, n_tiles - 1);
+            int y_1 = ofClamp(floor((ring_bounds.getTop() - bounds.y) / tile_h), 0, n_tiles - 1);
+            int y_2 = ofClamp(floor((ring_bounds.getBottom() - bounds.y) / tile_h), 0, n_tiles - 1);
+
+            for (int y = y_1; y <= y_2; y++){
+                for (int x = x_1; x <= x_2; x++){
+                    TileKey key = {z, x, y};
+                    // nothing is outside the pyramid: the tiles on its border
+                    // get some margin, for the points float rounding would leave out
+                    ofRectangle clip_rect = tile_bounds(bounds, key);
+                    if (x == 0) clip_rect.growToInclude(clip_rect.getLeft() - tile_w, clip_rect.y);
+                    if (y == 0) clip_rect.growToInclude(clip_rect.x, clip_rect.getTop() - tile_h);
+                    if (x == n_tiles - 1) clip_rect.growToInclude(clip_rect.getRight() + tile_w, clip_rect.y);
+                    if (y == n_tiles - 1) clip_rect.growToInclude(clip_rect.x, clip_rect.getBottom() + tile_h);
+
+                    vector <vector<ofPoint> > strips;
+                    clip_ring(simplified.getVertices(), clip_rect, strips);
+                    if (strips.empty()) continue;
+
+                    vector <vector<ofPoint> > & tile = tiles[key];
+                    tile.insert(tile.end(), strips.begin(), strips.end());
+                }
+            }
+        }
+
+        // tile file: uint32 number of strips, then for each strip uint32 number of points and the x, y floats
+        for (std::map <TileKey, vector<vector<ofPoint> > >::iterator it = tiles.begin(); it != tiles.end(); ++it){
+
+            ofstream file(ofToDataPath(tile_path(directory, it->first)).c_str(), ios::binary);
+
+            uint32_t n_rings = it->second.size();
+            file.write((const char *) &n_rings, sizeof(n_rings));
+
+            for (int i = 0; i < it->second.size(); i++){
+                const vector <ofPoint> & points = it->second[i];
+                uint32_t n_points = points.size();
+                file.write((const char *) &n_points, sizeof(n_points));
+                for (int p = 0; p < points.size(); p++){
+                    float xy[2] = {points[p].x, points[p].y};
+                    file.write((const char *) xy, sizeof(xy));
+                }
+            }
+        }
+
+        cout << "vv_tile_pyramid::build: zoom " << z << ", " << tiles.size() << " tiles" << endl;
+    }
+
+    ofBuffer manifest;
+    manifest.append("bounds " + ofToString(bounds.x) + " " + ofToString(bounds.y) + " " + ofToString(bounds.width) + " " + ofToString(bounds.height) + "\n");
+    manifest.append("max_zoom " + ofToString(max_zoom) + "\n");
+    ofBufferToFile(directory + "/pyramid.txt", manifest);
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool vv_tile_pyramid::read_manifest(std::string directory, ofRectangle & bounds, int & max_zoom){
+
+    std::string path = directory + "/pyramid.txt";
+    if (!ofFile::doesFileExist(path)) return false;
+
+    vector <string> words = ofSplitString(ofBufferFromFile(path).getText(), " \n", true, true);
+    if (words.size() < 7) return false;
+
+    bounds = ofRectangle(ofToFloat(words[1]), ofToFloat(words[2]), ofToFloat(words[3]), ofToFloat(words[4]));
+    max_zoom = ofToInt(words[6]);
+
+    return true;
+}
+
+//--------------------------------------------------------------
+// safe to call from any thread
+// @return: false if the tile doesn't exist (empty tiles are not written)
+//--------------------------------------------------------------
+bool vv_tile_pyramid::read_tile(std::string path, vector<ofMesh> & rings){
+
+    ifstream file(path.c_str(), ios::binary);
+    if (!file.is_open()) return false;
+
+    uint32_t n_rings = 0;
+    file.read((char *) &n_rings, sizeof(n_rings));
+
+    for (uint32_t r = 0; r < n_rings && file.good(); r++){
+
+        uint32_t n_points = 0;
+        file.read((char *) &n_points, sizeof(n_points));
+
+        vector <float> xy(n_points * 2);
+        if (n_points > 0) file.read((char *) &xy[0], xy.size() * sizeof(float));
+
+        ofMesh ring;
+        ring.setMode(OF_PRIMITIVE_LINE_STRIP);
+        for (uint32_t p = 0; p < n_points; p++){
+            ring.addVertex(ofVec3f(xy[p * 2], xy[p * 2 + 1], 0));
+        }
+        rings.push_back(ring);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+std::string vv_tile_pyramid::tile_path(std::string directory, TileKey key){
+    return directory + "/" + ofToString(key.z) + "/" + ofToString(key.x) + "_" + ofToString(key.y) + ".bin";
+}
+
+//--------------------------------------------------------------
+ofRectangle vv_tile_pyramid::tile_bounds(const ofRectangle & bounds, TileKey key){
+
+    int n_tiles = 1 << key.z;
+    float tile_w = bounds.getWidth() / n_tiles;
+    float tile_h = bounds.getHeight() / n_tiles;
+
+    return ofRectangle(bounds.x + key.x * tile_w, bounds.y + key.y * tile_h, tile_w, tile_h);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxJSON.h"
+#include "vv_map_projections.h"
+
+//--------------------------------------------------------------
+// Multi zoom tile pyramid of the map outlines, stored on disk.
+// Zoom 0 is a single tile covering the whole map, zoom z has 2^z x 2^z tiles.
+// Each tile holds the pieces of the (mercator projected) rings that fall
+// inside it, as line strips clipped to its bounds and simplified for the size
+// of the tile, so a deeper tile holds less, not more. See TileStreamer for
+// the runtime side.
+//
+// directory/pyramid.txt     bounds and max zoom
+// directory/z/x_y.bin       one binary file per non empty tile
+//--------------------------------------------------------------
+
+namespace vv_tile_pyramid {
+
+    struct TileKey {
+        int z, x, y;
+        bool operator<(const TileKey & other) const {
+            if (z != other.z) return z < other.z;
+            if (x != other.x) return x < other.x;
+            return y < other.y;
+        }
+        bool operator==(const TileKey & other) const {
+            return z == other.z && x == other.x && y == other.y;
+        }
+    };
+
+    bool build(std::string geojson_path, std::string directory, int max_zoom, float scale);
+
+    bool read_manifest(std::string directory, ofRectangle & bounds, int & max_zoom);
+    bool read_tile(std::string path, vector<ofMesh> & rings);
+    std::string tile_path(std::string directory, TileKey key);
+    ofRectangle tile_bounds(const ofRectangle & bounds, TileKey key);
+}
@@ -0,0 +1,118 @@
+#include "vv_trace.h"
+
+namespace {
+
+    struct Event {
+        std::string name;
+        uint64_t start, duration; // micros
+        int thread;
+    };
+
+    std::mutex trace_mutex;
+    bool trace_enabled = true;
+    vector <Event> events;
+    std::map <std::thread::id, int> thread_ids;
+    // open spans of each thread
+    std::map <int, vector<Event> > open_spans;
+
+    // called with trace_mutex held
+    int current_thread(){
+        std::thread::id id = std::this_thread::get_id();
+        std::map <std::thread::id, int>::iterator it = thread_ids.find(id);
+        if (it != thread_ids.end()) return it->second;
+        int thread = thread_ids.size() + 1;
+        thread_ids[id] = thread;
+        return thread;
+    }
+
+    std::string escape(const std::string & s){
+        std::string escaped;
+        for (int i = 0; i < s.size(); i++){
+            if (s[i] == '"' || s[i] == '\\') escaped += '\\';
+            if (s[i] == '\n') escaped += "\\n";
+            else escaped += s[i];
+        }
+        return escaped;
+    }
+}
+
+//--------------------------------------------------------------
+void vv_trace::set_enabled(bool enabled){
+    std::unique_lock<std::mutex> lock(trace_mutex);
+    trace_enabled = enabled;
+}
+
+//--------------------------------------------------------------
+bool vv_trace::is_enabled(){
+    std::unique_lock<std::mutex> lock(trace_mutex);
+    return trace_enabled;
+}
+
+//--------------------------------------------------------------
+void vv_trace::begin(std::string name){
+
+    uint64_t now = ofGetElapsedTimeMicros();
+
+    std::unique_lock<std::mutex> lock(trace_mutex);
+    if (!trace_enabled) return;
+
+    Event event;
+    event.name = name;
+    event.start = now;
+    event.duration = 0;
+    event.thread = current_thread();
+    open_spans[event.thread].push_back(event);
+}
+
+//--------------------------------------------------------------
+// closes the innermost open span of the calling thread
+//--------------------------------------------------------------
+void vv_trace::end(){
+
+    uint64_t now = ofGetElapsedTimeMicros();
+
+    std::unique_lock<std::mutex> lock(trace_mutex);
+    if (!trace_enabled) return;
+
+    vector <Event> & spans = open_spans[current_thread()];
+    if (spans.empty()) return;
+
+    Event event = spans.back();
+    spans.pop_back();
+    event.duration = now - event.start;
+    events.push_back(event);
+}
+
+//--------------------------------------------------------------
+// @return: false if the file couldn't be written
+//--------------------------------------------------------------
+bool vv_trace::save(std::string path){
+
+    std::unique_lock<std::mutex> lock(trace_mutex);
+
+    ofstream file(ofToDataPath(path).c_str());
+    if (!file.is_open()) return false;
+
+    // complete events ("ph": "X"), the viewer nests them by time
+    file << "{\"traceEvents\":[\n";
+    for (int i = 0; i < events.size(); i++){
+        const Event & event = events[i];
+        file << "{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1";
+        file << ",\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+        file << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    file << "],\"displayTimeUnit\":\"ms\"}\n";
+
+    cout << "vv_trace::save: " << events.size() << " spans saved to " << path << endl;
+
+    return true;
+}
+
+//--------------------------------------------------------------
+// @desc:   forgets every span and gives their memory back
+//--------------------------------------------------------------
+void vv_trace::clear(){
+    std::unique_lock<std::mutex> lock(trace_mutex);
+    vector <Event>().swap(events);
+    open_spans.clear();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "ofMain.h"
+
+//--------------------------------------------------------------
+// Nested timing spans saved as Chrome trace-event json
+// (open it with chrome://tracing or https://ui.perfetto.dev).
+// Spans can be recorded from any thread, each thread gets its own row.
+//
+// @example:
+//
+// void ofApp::setup(){
+//     {
+//         vv_trace::Span span("load fonts");
+//         font.load(...);
+//     }
+//     vv_trace::save("startup_trace.json");
+//     vv_trace::set_enabled(false); // spans pile up in memory until cleared
+//     vv_trace::clear();
+// }
+//--------------------------------------------------------------
+
+namespace vv_trace {
+
+    void set_enabled(bool enabled);
+    bool is_enabled();
+
+    // prefer Span, those are for code that is not in its own block
+    void begin(std::string name);
+    void end();
+
+    bool save(std::string path); // relative to bin/data
+    void clear(); // frees the recorded spans
+
+    class Span {
+        public:
+            Span(std::string name){ begin(name); }
+            ~Span(){ end(); }
+    };
+}